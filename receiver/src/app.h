@@ -3,6 +3,9 @@
 #include <stdint.h>
 #include <memory>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 // Connect all our code together
 #include "demodulator/qam_sync.h"
@@ -13,6 +16,8 @@
 #include "utility/span.h"
 #include "utility/reconstruction_buffer.h"
 #include "utility/observable.h"
+#include "utility/spsc_queue.h"
+#include "utility/sample_source.h"
 
 #define PRINT_LOG 1
 #if PRINT_LOG 
@@ -166,17 +171,24 @@ class App
 {
 public:
     QAM_Synchroniser_Specification qam_sync_spec;
+    // Set by the gui thread and cleared by the receiver thread once it acts on them
     struct {
-        bool rebuild = false;
-        bool snapshot = false;
+        std::atomic<bool> rebuild{false};
+        std::atomic<bool> snapshot{false};
     } controls;
     bool is_read_loop = false;
-    bool is_running = true;
+    std::atomic<bool> is_running{true};
 private:
-    FILE* rx_fp;
+    SampleSource& rx_source;
+    const bool is_diagnostics;
     std::unique_ptr<ConstellationSpecification> constellation;
     std::unique_ptr<QAM_Synchroniser_Buffer> active_buffer;
     std::unique_ptr<QAM_Synchroniser_Buffer> snapshot_buffer;
+    // Receiver thread copies into the pending snapshot which the gui thread swaps in when it is ready
+    // The pending buffer and flag are guarded by mutex_snapshot
+    std::unique_ptr<QAM_Synchroniser_Buffer> pending_snapshot_buffer;
+    std::mutex mutex_snapshot;
+    bool is_snapshot_pending = false;
 
     std::unique_ptr<QAM_Synchroniser> qam_sync;
     std::unique_ptr<FrameDecoder> frame_decoder;
@@ -184,14 +196,17 @@ private:
     std::unique_ptr<AudioFilter> audio_filter;
 public:
     App(
-        FILE* _rx_fp, const int demod_block_size,
+        SampleSource& _rx_source, const int demod_block_size,
         const int decoder_block_size, const int ds_factor, const int us_factor,
-        const int audio_block_size, const float F_audio) 
-    : rx_fp(_rx_fp)
+        const int audio_block_size, const float F_audio,
+        // Headless applications can skip writing the per sample diagnostic buffers
+        const bool _is_diagnostics=true) 
+    : rx_source(_rx_source), is_diagnostics(_is_diagnostics)
     {
         constellation = std::make_unique<SquareConstellation>(4);
-        active_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor);
-        snapshot_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor);
+        active_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, is_diagnostics);
+        snapshot_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, is_diagnostics);
+        pending_snapshot_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, is_diagnostics);
 
         {
             const uint32_t preamble_code = 0b11111001101011111100110101101101;
@@ -218,12 +233,11 @@ public:
         while (is_running) {
             // read baseband
             auto rx_buffer = active_buffer->x_raw;
-            auto rx_length = active_buffer->GetInputSize();
-            size_t rd_block_size = fread(rx_buffer.data(), sizeof(std::complex<uint8_t>), rx_length, rx_fp);
+            const size_t rx_length = (size_t)active_buffer->GetInputSize();
+            size_t rd_block_size = rx_source.Read(rx_buffer);
             if (rd_block_size != rx_length) {
                 LOG_MESSAGE("Got mismatched block size after %d blocks\n", rd_total_blocks);
-                if (is_read_loop) {
-                    fseek(rx_fp, 0, 0);
+                if (is_read_loop && rx_source.Rewind()) {
                     continue;
                 }
                 break;
@@ -234,21 +248,123 @@ public:
             if (qam_sync) {
                 const int nb_symbols = qam_sync->ProcessBlock(*(active_buffer.get()));
                 auto syms = active_buffer->y_out.first(nb_symbols);
-                for (auto& sym: syms) {
-                    auto res = frame_decoder->process(sym);
-                    auto payload = frame_decoder->GetPayload();
+                frame_decoder->process(syms, [this](auto res, const auto& payload) {
                     audio_frame_handler->OnFrameResult(res, payload);
-                }
+                });
             }
 
             if (ReadFlag(controls.snapshot)) {
-                snapshot_buffer->CopyFrom(*(active_buffer.get()));
+                TakeSnapshot(*(active_buffer.get()));
             }
 
             if (ReadFlag(controls.rebuild)) {
                 BuildDemodulator();
             }
         }
+
+        // Deliver frames that are still queued in the batch viterbi decoder
+        frame_decoder->Flush([this](auto res, const auto& payload) {
+            audio_frame_handler->OnFrameResult(res, payload);
+        });
+    }
+    // Run each stage of the receiver on its own thread so consecutive blocks are processed concurrently
+    // 1. Read baseband + front end filtering (calling thread)
+    // 2. Carrier and timing recovery
+    // 3. Frame decoding + handlers
+    // Blocks are passed between stages through lock free queues and recycled once decoded
+    void RunPipelined(const int nb_buffers=4) {
+        struct Block {
+            QAM_Synchroniser_Buffer* buffer = NULL;
+            int nb_symbols = 0;
+        };
+
+        const int demod_block_size = active_buffer->GetPLLSize();
+        const int ds_factor = active_buffer->GetDownsamplingFactor();
+        const int us_factor = active_buffer->GetUpsamplingFactor();
+        auto buffers = std::vector<std::unique_ptr<QAM_Synchroniser_Buffer>>();
+        auto free_queue = SPSC_Queue<QAM_Synchroniser_Buffer*>(nb_buffers);
+        auto sync_queue = SPSC_Queue<Block>(nb_buffers);
+        auto decode_queue = SPSC_Queue<Block>(nb_buffers);
+        // Buffers held by the reader which are not inside the pipeline
+        auto idle_buffers = std::vector<QAM_Synchroniser_Buffer*>();
+        for (int i = 0; i < nb_buffers; i++) {
+            buffers.push_back(std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, is_diagnostics));
+            idle_buffers.push_back(buffers.back().get());
+        }
+
+        // A block with a NULL buffer signals the end of the stream
+        auto sync_thread = std::thread([this, &sync_queue, &decode_queue]() {
+            while (true) {
+                auto block = sync_queue.Pop();
+                if (block.buffer && qam_sync) {
+                    block.nb_symbols = qam_sync->ProcessSync(*block.buffer);
+                }
+                decode_queue.Push(block);
+                if (block.buffer == NULL) {
+                    break;
+                }
+            }
+        });
+
+        auto decode_thread = std::thread([this, &decode_queue, &free_queue]() {
+            while (true) {
+                auto block = decode_queue.Pop();
+                if (block.buffer == NULL) {
+                    frame_decoder->Flush([this](auto res, const auto& payload) {
+                        audio_frame_handler->OnFrameResult(res, payload);
+                    });
+                    break;
+                }
+                auto syms = block.buffer->y_out.first(block.nb_symbols);
+                frame_decoder->process(syms, [this](auto res, const auto& payload) {
+                    audio_frame_handler->OnFrameResult(res, payload);
+                });
+                if (ReadFlag(controls.snapshot)) {
+                    TakeSnapshot(*block.buffer);
+                }
+                free_queue.Push(block.buffer);
+            }
+        });
+
+        is_running = true;
+        int rd_total_blocks = 0;
+        while (is_running) {
+            if (ReadFlag(controls.rebuild)) {
+                // Wait for all blocks to leave the pipeline before replacing the demodulator
+                while (idle_buffers.size() < buffers.size()) {
+                    idle_buffers.push_back(free_queue.Pop());
+                }
+                BuildDemodulator();
+            }
+
+            if (idle_buffers.empty()) {
+                idle_buffers.push_back(free_queue.Pop());
+            }
+            auto* buffer = idle_buffers.back();
+
+            // read baseband
+            auto rx_buffer = buffer->x_raw;
+            const size_t rx_length = (size_t)buffer->GetInputSize();
+            size_t rd_block_size = rx_source.Read(rx_buffer);
+            if (rd_block_size != rx_length) {
+                LOG_MESSAGE("Got mismatched block size after %d blocks\n", rd_total_blocks);
+                if (is_read_loop && rx_source.Rewind()) {
+                    continue;
+                }
+                break;
+            }
+            rd_total_blocks++; 
+            idle_buffers.pop_back();
+
+            if (qam_sync) {
+                qam_sync->ProcessFrontEnd(*buffer);
+            }
+            sync_queue.Push({ buffer, 0 });
+        }
+
+        sync_queue.Push({ NULL, 0 });
+        sync_thread.join();
+        decode_thread.join();
     }
     void Stop() {
         is_running = false;
@@ -258,13 +374,26 @@ public:
     }
 public:
     auto& GetActiveBuffer() { return *(active_buffer.get()); }
-    auto& GetSnapshotBuffer() { return *(snapshot_buffer.get()); }
+    // Swaps in the latest snapshot, the returned buffer is only valid until the next call
+    // NOTE: Must be called from the thread which reads the snapshot
+    auto& GetSnapshotBuffer() {
+        auto lock = std::scoped_lock(mutex_snapshot);
+        if (is_snapshot_pending) {
+            std::swap(snapshot_buffer, pending_snapshot_buffer);
+            is_snapshot_pending = false;
+        }
+        return *(snapshot_buffer.get());
+    }
     auto& GetAudioFilter() { return *(audio_filter.get()); }
     auto& GetFrameHandler() { return *(audio_frame_handler.get()); }
+    auto& GetFrameDecoder() { return *(frame_decoder.get()); }
 private:
-    bool ReadFlag(bool& flag) {
-        const bool rv = flag;
-        flag = false;
-        return rv;
+    bool ReadFlag(std::atomic<bool>& flag) {
+        return flag.exchange(false);
+    }
+    void TakeSnapshot(QAM_Synchroniser_Buffer& buffer) {
+        auto lock = std::scoped_lock(mutex_snapshot);
+        pending_snapshot_buffer->CopyFrom(buffer);
+        is_snapshot_pending = true;
     }
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+// Benchmark the crc8 and crc32 calculators for different message lengths
+// Each method is checked against the bytewise crc of the same random data at several start offsets
+// Reports the throughput in GB/s
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "decoder/crc8.h"
+#include "decoder/crc32.h"
+#include "utility/getopt/getopt.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_crc, benchmarks the crc calculators for different message lengths\n\n"
+        "\t[-n total number of bytes processed per length (default: 67108864)]\n"
+        "\t[-r number of repeats (default: 5)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+struct Result {
+    double gigabytes_per_second;
+    bool is_match;
+};
+
+// prevents the benchmarked calls from being optimised away
+volatile uint32_t crc_sink = 0;
+
+// messages are also checked at unaligned offsets so the head and tail handling of each method is covered
+const int CHECK_OFFSETS[] = { 0, 1, 3, 7, 13, 31 };
+
+// Method and reference are callables which return the crc of a message
+template <typename T, typename F, typename G>
+Result run_method(F&& method, G&& reference, const std::vector<uint8_t>& data, const int length, const int nb_total_bytes, const int nb_repeats) {
+    const int nb_messages = (nb_total_bytes + length-1) / length;
+    const int nb_offsets = (int)data.size() - length + 1;
+
+    Result res;
+    res.is_match = true;
+    double dt_best = INFINITY;
+    for (int r = 0; r < nb_repeats; r++) {
+        T crc_acc = 0;
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < nb_messages; i++) {
+            crc_acc ^= method(&data[(i*64) % nb_offsets], length);
+        }
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        const double dt = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        dt_best = (dt < dt_best) ? dt : dt_best;
+        crc_sink = crc_sink ^ (uint32_t)crc_acc;
+    }
+
+    for (const int offset: CHECK_OFFSETS) {
+        const T expected = reference(&data[offset], length);
+        res.is_match = res.is_match && (method(&data[offset], length) == expected);
+    }
+
+    res.gigabytes_per_second = (double)nb_messages * (double)length / dt_best;
+    return res;
+}
+
+template <typename T, typename Engine>
+void run_engine(const char* name, const Engine& engine, const std::vector<uint8_t>& data, const int nb_total_bytes, const int nb_repeats) {
+    // odd lengths leave a partial block for the tail handling of each method
+    const int lengths[] = { 16, 63, 64, 65, 79, 100, 256, 1024, 4096, 65536 };
+
+    auto print = [name](const char* method, const int length, const Result& res) {
+        fprintf(stdout, "%-6s %-10s %8d %12.3f %8s\n", name, method, length, res.gigabytes_per_second, res.is_match ? "ok" : "MISMATCH");
+    };
+
+    auto reference = [&engine](const uint8_t* x, const int N) {
+        return engine.process_bytewise(x, N);
+    };
+
+    for (const int length: lengths) {
+        print("bytewise", length, run_method<T>([&engine](const uint8_t* x, const int N) {
+            return engine.process_bytewise(x, N);
+        }, reference, data, length, nb_total_bytes, nb_repeats));
+        print("slice8", length, run_method<T>([&engine](const uint8_t* x, const int N) {
+            return engine.process_slice8(x, N);
+        }, reference, data, length, nb_total_bytes, nb_repeats));
+        #if defined(_DSP_PCLMUL) && defined(_DSP_SSSE3)
+        print("clmul", length, run_method<T>([&engine](const uint8_t* x, const int N) {
+            return engine.process_clmul(x, N);
+        }, reference, data, length, nb_total_bytes, nb_repeats));
+        #endif
+        print("auto", length, run_method<T>([&engine](const uint8_t* x, const int N) {
+            return engine.process(x, N);
+        }, reference, data, length, nb_total_bytes, nb_repeats));
+    }
+}
+
+int main(int argc, char** argv) {
+    int nb_total_bytes = 1 << 26;
+    int nb_repeats = 5;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "n:r:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            nb_total_bytes = (int)(atof(optarg));
+            if (nb_total_bytes <= 0) {
+                fprintf(stderr, "Number of bytes must be positive (%d)\n", nb_total_bytes);
+                return 1;
+            }
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    // messages start at different offsets of a buffer that fits in cache
+    std::vector<uint8_t> data(1 << 17);
+    auto rng = std::mt19937(1234);
+    auto byte_dist = std::uniform_int_distribution<int>(0, 255);
+    for (auto& v: data) {
+        v = (uint8_t)byte_dist(rng);
+    }
+
+    const auto crc8_calc = CRC8_Calculator(0xD5);
+    const auto crc32_calc = CRC32_Calculator(0x04C11DB7);
+
+    fprintf(stdout, "%-6s %-10s %8s %12s %8s\n", "crc", "method", "length", "GB/s", "check");
+    run_engine<uint8_t>("crc8", crc8_calc, data, nb_total_bytes, nb_repeats);
+    run_engine<uint32_t>("crc32", crc32_calc, data, nb_total_bytes, nb_repeats);
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Benchmark the carrier pll mixer for each oscillator type
+// Reports the time and cycles per sample as well as the worst case error against double precision cos/sin
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <cmath>
+#include <complex>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#include "demodulator/pll_mixer.h"
+#include "utility/getopt/getopt.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_pll_mixer, benchmarks the oscillator used in the carrier pll\n\n"
+        "\t[-n number of samples (default: 4194304)]\n"
+        "\t[-r number of repeats (default: 5)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+struct Result {
+    double ns_per_sample;
+    double cycles_per_sample;
+    double max_error;
+};
+
+Result run_benchmark(const PLL_Oscillator oscillator, const int N, const int nb_repeats) {
+    const float Fs = 500e3f;
+    Result res;
+    res.ns_per_sample = INFINITY;
+    res.cycles_per_sample = INFINITY;
+    res.max_error = 0.0;
+
+    for (int r = 0; r < nb_repeats; r++) {
+        PLL_mixer mixer;
+        mixer.oscillator = oscillator;
+        mixer.integrator.KTs = 1.0f/Fs;
+        mixer.fcenter = 1.234e3f;
+        mixer.fgain = 2.5e3f;
+        mixer.phase_error_gain = 1.0f;
+
+        // Vary the control signal like the loop filter does
+        auto sum = std::complex<float>(0,0);
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        const uint64_t c0 = __rdtsc();
+        for (int i = 0; i < N; i++) {
+            mixer.phase_error = (float)(i & 0xFF) * (1.0f/256.0f) - 0.5f;
+            sum += mixer.update();
+        }
+        const uint64_t c1 = __rdtsc();
+        const auto t1 = std::chrono::high_resolution_clock::now();
+
+        const double dt = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        const double ns_per_sample = dt/(double)N;
+        const double cycles_per_sample = (double)(c1-c0)/(double)N;
+        res.ns_per_sample = (ns_per_sample < res.ns_per_sample) ? ns_per_sample : res.ns_per_sample;
+        res.cycles_per_sample = (cycles_per_sample < res.cycles_per_sample) ? cycles_per_sample : res.cycles_per_sample;
+        // Prevent the loop from being optimised away
+        if (std::abs(sum) < 0.0f) {
+            fprintf(stderr, "unreachable\n");
+        }
+    }
+
+    // Sweep the phase and compare against the reference phasor
+    if (oscillator != PLL_Oscillator::STD_MATH) {
+        NCO nco;
+        const int M = 1 << 20;
+        for (int i = 0; i < M; i++) {
+            nco.phase = (uint32_t)(i) * 4093u * 1021u;
+            const auto y = (oscillator == PLL_Oscillator::LUT) ? nco.get_output<false>() : nco.get_output<true>();
+            const double PI = 3.14159265358979323846;
+            const double t = (double)nco.phase / 4294967296.0 * 2.0 * PI;
+            const double I = std::cos(t) - (double)y.real();
+            const double Q = std::sin(t) - (double)y.imag();
+            const double err = std::sqrt(I*I + Q*Q);
+            res.max_error = (err > res.max_error) ? err : res.max_error;
+        }
+    }
+
+    return res;
+}
+
+int main(int argc, char** argv) {
+    int N = 1 << 22;
+    int nb_repeats = 5;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "n:r:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            N = (int)(atof(optarg));
+            if (N <= 0) {
+                fprintf(stderr, "Number of samples must be positive (%d)\n", N);
+                return 1;
+            }
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    struct {
+        const char* name;
+        PLL_Oscillator oscillator;
+    } configs[] = {
+        { "std_math", PLL_Oscillator::STD_MATH },
+        { "lut", PLL_Oscillator::LUT },
+        { "lut_interpolate", PLL_Oscillator::LUT_INTERPOLATE },
+    };
+
+    fprintf(stdout, "%-16s %14s %14s %14s\n", "oscillator", "ns/sample", "cycles/sample", "max_error");
+    for (auto& config: configs) {
+        const auto res = run_benchmark(config.oscillator, N, nb_repeats);
+        fprintf(stdout, "%-16s %14.2f %14.2f %14.3e\n", config.name, res.ns_per_sample, res.cycles_per_sample, res.max_error);
+    }
+
+    return 0;
+}
@@ -0,0 +1,527 @@
+// Benchmark the full receiver chain for different block sizes and resampling factors
+// A deterministic stream of audio frames is generated in process by the simulator
+// QAM_Synchroniser (front end + sync) --> FrameDecoder --> AudioFilter
+// Reports the throughput and the time spent in each stage as json
+// With batch decoding the payload order is checked against a decoder without batching
+// The check feeds both decoders blocks with an odd number of symbols so frames also end on a partial byte
+// The whole App is also timed end to end with App::Run and with the multithreaded App::RunPipelined
+// Generating the input stream is not included in any of the timings
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "app.h"
+#include "simulator/frame_encoder.h"
+#include "simulator/iq_modulator.h"
+#include "simulator/channel_model.h"
+#include "simulator/gaussian_noise.h"
+#include "simulator/simulator_source.h"
+#include "utility/getopt/getopt.h"
+#include "utility/span.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_receiver, benchmarks the receiver chain and reports the results as json\n\n"
+        "\t[-f sample rate (default: 1MHz)]\n"
+        "\t[-s symbol rate (default: 200kHz)]\n"
+        "\t[-b block sizes separated by commas (default: 2048,4096,8192,16384)]\n"
+        "\t[-D downsample factors separated by commas (default: 2)]\n"
+        "\t[-S upsample factors separated by commas (default: 4)]\n"
+        "\t[-t duration of the input stream in seconds (default: 4)]\n"
+        "\t[-n Es/N0 of the input stream in dB (default: no noise)]\n"
+        "\t[-r number of repeats (default: 3)]\n"
+        "\t[-V decode frames in batches with the SIMD viterbi decoder (default: false)]\n"
+        "\t[-o output json filename (default: stdout)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+// NOTE: The frame handler treats payloads of this size as audio
+constexpr int AUDIO_PACKET_BLOCK_SIZE = 100;
+// Odd number of symbols per block for the batch order check
+constexpr int ORDER_CHECK_BLOCK_SIZE = 101;
+
+struct Config {
+    int block_size;
+    int ds_factor;
+    int us_factor;
+};
+
+struct Result {
+    Config config;
+    uint64_t total_samples = 0;
+    int total_symbols = 0;
+    int frames_correct = 0;
+    int frames_incorrect = 0;
+    // payloads delivered out of order in batch mode compared to without batching
+    int batch_order_payloads = 0;
+    int batch_order_mismatches = 0;
+    // nanoseconds spent in each stage
+    double dt_front_end = 0.0;
+    double dt_sync = 0.0;
+    double dt_decoder = 0.0;
+    double dt_audio = 0.0;
+    // nanoseconds for App::Run and App::RunPipelined over the same stream
+    double dt_app_serial = 0.0;
+    double dt_app_pipelined = 0.0;
+    int app_frames_serial = 0;
+    int app_frames_pipelined = 0;
+    double GetTotalTime() const {
+        return dt_front_end + dt_sync + dt_decoder + dt_audio;
+    }
+};
+
+bool parse_int_list(const char* arg, std::vector<int>& values);
+std::vector<uint8_t> create_audio_frames(const int nb_frames);
+QAM_Synchroniser_Specification create_qam_sync_spec(const float Fsample, const float Fsymbol, const Config& config);
+Result run_config(
+    const IQ_Modulator& modulator, const ChannelSpecification* channel_spec,
+    const float Fsample, const float Fsymbol, const Config& config,
+    const uint64_t total_samples, const bool is_batch_viterbi);
+std::vector<std::complex<uint8_t>> create_input_stream(
+    const IQ_Modulator& modulator, const ChannelSpecification* channel_spec,
+    const uint64_t total_samples);
+double run_app(
+    tcb::span<const std::complex<uint8_t>> stream,
+    const float Fsample, const float Fsymbol, const Config& config,
+    const bool is_batch_viterbi, const bool is_pipelined, int& frames_correct);
+void write_json(FILE* fp, const std::vector<Result>& results, const float Fsample, const float Fsymbol, const bool is_batch_viterbi);
+
+template <typename F>
+double get_elapsed_ns(F&& func) {
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    func();
+    const auto t1 = std::chrono::high_resolution_clock::now();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+}
+
+int main(int argc, char** argv) {
+    float Fsample = 1e6;
+    float Fsymbol = 200e3;
+    auto block_sizes = std::vector<int>{ 2048, 4096, 8192, 16384 };
+    auto ds_factors = std::vector<int>{ 2 };
+    auto us_factors = std::vector<int>{ 4 };
+    float duration = 4.0f;
+    float EsN0_dB = INFINITY;
+    int nb_repeats = 3;
+    bool is_batch_viterbi = false;
+    const char* filename = NULL;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "f:s:b:D:S:t:n:r:Vo:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            Fsample = (float)(atof(optarg));
+            if (Fsample <= 0) {
+                fprintf(stderr, "Sampling rate must be positive (%.2f)\n", Fsample);
+                return 1;
+            }
+            break;
+        case 's':
+            Fsymbol = (float)(atof(optarg));
+            if (Fsymbol <= 0) {
+                fprintf(stderr, "Symbol rate must be positive (%.2f)\n", Fsymbol);
+                return 1;
+            }
+            break;
+        case 'b':
+            if (!parse_int_list(optarg, block_sizes)) {
+                fprintf(stderr, "Block sizes must be positive integers (%s)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'D':
+            if (!parse_int_list(optarg, ds_factors)) {
+                fprintf(stderr, "Downsampling factors must be positive integers (%s)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'S':
+            if (!parse_int_list(optarg, us_factors)) {
+                fprintf(stderr, "Upsampling factors must be positive integers (%s)\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            duration = (float)(atof(optarg));
+            if (duration <= 0.0f) {
+                fprintf(stderr, "Duration must be positive (%.2f)\n", duration);
+                return 1;
+            }
+            break;
+        case 'n':
+            EsN0_dB = (float)(atof(optarg));
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'V':
+            is_batch_viterbi = true;
+            break;
+        case 'o':
+            filename = optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    const float Nsamples = Fsample / Fsymbol;
+    if (std::abs(Nsamples - std::round(Nsamples)) > 1e-3f) {
+        fprintf(stderr, "Sample rate must be a multiple of the symbol rate (%.2f)\n", Nsamples);
+        return 1;
+    }
+
+    FILE* fp_out = stdout;
+    if (filename != NULL) {
+        fp_out = fopen(filename, "w");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open file: %s\n", filename);
+            return 1;
+        }
+    }
+
+    // The modulator loops the frames so only a small number of them are needed
+    auto modulator = IQ_Modulator(ModulationType::QAM16, (int)std::round(Nsamples));
+    modulator.SetData(create_audio_frames(1000));
+
+    auto channel_spec = ChannelSpecification();
+    channel_spec.EsN0_dB = EsN0_dB;
+    const bool is_channel = std::isfinite(EsN0_dB);
+    const uint64_t total_samples = (uint64_t)((double)duration * (double)Fsample);
+
+    auto results = std::vector<Result>();
+    for (const int ds_factor: ds_factors) {
+        for (const int us_factor: us_factors) {
+            for (const int block_size: block_sizes) {
+                const Config config = { block_size, ds_factor, us_factor };
+                Result best;
+                for (int i = 0; i < nb_repeats; i++) {
+                    const auto res = run_config(
+                        modulator, is_channel ? &channel_spec : NULL,
+                        Fsample, Fsymbol, config,
+                        total_samples, is_batch_viterbi);
+                    if ((i == 0) || (res.GetTotalTime() < best.GetTotalTime())) {
+                        best = res;
+                    }
+                }
+
+                const auto stream = create_input_stream(modulator, is_channel ? &channel_spec : NULL, best.total_samples);
+                for (int i = 0; i < nb_repeats; i++) {
+                    for (const bool is_pipelined: { false, true }) {
+                        int frames_correct = 0;
+                        const double dt = run_app(stream, Fsample, Fsymbol, config, is_batch_viterbi, is_pipelined, frames_correct);
+                        double& dt_best = is_pipelined ? best.dt_app_pipelined : best.dt_app_serial;
+                        int& frames_best = is_pipelined ? best.app_frames_pipelined : best.app_frames_serial;
+                        if ((i == 0) || (dt < dt_best)) {
+                            dt_best = dt;
+                            frames_best = frames_correct;
+                        }
+                    }
+                }
+
+                const double N = (double)best.total_samples;
+                fprintf(stderr, "b=%d D=%d S=%d: %.2f MS/s, app serial %.2f MS/s, app pipelined %.2f MS/s\n",
+                    block_size, ds_factor, us_factor,
+                    N / best.GetTotalTime() * 1e3,
+                    N / best.dt_app_serial * 1e3,
+                    N / best.dt_app_pipelined * 1e3);
+                if (is_batch_viterbi) {
+                    fprintf(stderr, "b=%d D=%d S=%d: batch order mismatches %d/%d payloads\n",
+                        block_size, ds_factor, us_factor,
+                        best.batch_order_mismatches, best.batch_order_payloads);
+                }
+                results.push_back(best);
+            }
+        }
+    }
+
+    write_json(fp_out, results, Fsample, Fsymbol, is_batch_viterbi);
+    if (fp_out != stdout) {
+        fclose(fp_out);
+    }
+    return 0;
+}
+
+bool parse_int_list(const char* arg, std::vector<int>& values) {
+    values.clear();
+    const char* curr = arg;
+    while (*curr) {
+        char* end = NULL;
+        const long v = strtol(curr, &end, 10);
+        if ((end == curr) || (v <= 0)) {
+            return false;
+        }
+        values.push_back((int)v);
+        curr = end;
+        if (*curr == ',') {
+            curr++;
+        } else if (*curr != '\0') {
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+std::vector<uint8_t> create_audio_frames(const int nb_frames) {
+    const int nb_encoded_bytes = FrameEncoder::GetEncodedSize(AUDIO_PACKET_BLOCK_SIZE);
+    auto encoded = std::vector<uint8_t>(nb_frames*nb_encoded_bytes);
+    auto payload_words = std::vector<uint32_t>((AUDIO_PACKET_BLOCK_SIZE+3)/4);
+    auto payload = tcb::span(reinterpret_cast<uint8_t*>(payload_words.data()), (size_t)AUDIO_PACKET_BLOCK_SIZE);
+    auto rng = GaussianNoiseGenerator(1234);
+    auto encoder = FrameEncoder();
+    for (int i = 0; i < nb_frames; i++) {
+        rng.GenerateUniform(payload_words);
+        encoder.CreateFrame(payload, { &encoded[i*nb_encoded_bytes], (size_t)nb_encoded_bytes });
+    }
+    return encoded;
+}
+
+// Same settings as read_data
+QAM_Synchroniser_Specification create_qam_sync_spec(const float Fsample, const float Fsymbol, const Config& config) {
+    const float PI = 3.1415f;
+    auto spec = QAM_Synchroniser_Specification();
+    spec.f_sample = Fsample;
+    spec.f_symbol = Fsymbol;
+
+    spec.downsampling_filter.M = config.ds_factor;
+    spec.downsampling_filter.K = 6;
+
+    spec.upsampling_filter.L = config.us_factor;
+    spec.upsampling_filter.K = 6;
+
+    spec.ac_filter.k = 0.99999f;
+    spec.agc.beta = 0.2f;
+    spec.agc.initial_gain = 0.1f;
+    spec.carrier_pll.f_center = 0e3;
+    spec.carrier_pll.f_gain = 2.5e3;
+    spec.carrier_pll.phase_error_gain = 8.0f/PI;
+    spec.carrier_pll_filter.butterworth_cutoff = 5e3;
+    spec.carrier_pll_filter.integrator_gain = 1000.0f;
+    spec.ted_pll.f_gain = 30e3;
+    spec.ted_pll.f_offset = 0e3;
+    spec.ted_pll.phase_error_gain = 1.0f;
+    spec.ted_pll_filter.butterworth_cutoff = 60e3;
+    spec.ted_pll_filter.integrator_gain = 250.0f;
+    return spec;
+}
+
+// Each stage is timed separately for every block
+// Audio payloads are collected during decoding and then passed through the audio filter
+Result run_config(
+    const IQ_Modulator& modulator, const ChannelSpecification* channel_spec,
+    const float Fsample, const float Fsymbol, const Config& config,
+    const uint64_t total_samples, const bool is_batch_viterbi)
+{
+    auto channel = std::unique_ptr<ChannelModel>(nullptr);
+    auto rx_source = std::unique_ptr<SimulatorSampleSource>(nullptr);
+    if (channel_spec) {
+        channel = std::make_unique<ChannelModel>(*channel_spec, modulator);
+        rx_source = std::make_unique<SimulatorSampleSource>(*channel);
+    } else {
+        rx_source = std::make_unique<SimulatorSampleSource>(modulator);
+    }
+
+    auto constellation = SquareConstellation(4);
+    auto qam_sync = QAM_Synchroniser(create_qam_sync_spec(Fsample, Fsymbol, config), constellation);
+    auto buffer = QAM_Synchroniser_Buffer(config.block_size, config.ds_factor, config.us_factor, false);
+
+    const int decoder_block_size = 1024;
+    const uint8_t conv_poly[2] = { (uint8_t)FrameEncoder::CONV_POLY[0], (uint8_t)FrameEncoder::CONV_POLY[1] };
+    auto frame_decoder = FrameDecoder(
+        decoder_block_size, constellation,
+        FrameEncoder::PREAMBLE_CODE, FrameEncoder::SCRAMBLER_CODE,
+        conv_poly, FrameEncoder::CRC8_POLY);
+    frame_decoder.SetBatchViterbi(is_batch_viterbi);
+    // The decoders for the batch order check are not timed and are only run in batch mode
+    auto check_frame_decoder = FrameDecoder(
+        decoder_block_size, constellation,
+        FrameEncoder::PREAMBLE_CODE, FrameEncoder::SCRAMBLER_CODE,
+        conv_poly, FrameEncoder::CRC8_POLY);
+    auto ref_frame_decoder = FrameDecoder(
+        decoder_block_size, constellation,
+        FrameEncoder::PREAMBLE_CODE, FrameEncoder::SCRAMBLER_CODE,
+        conv_poly, FrameEncoder::CRC8_POLY);
+    check_frame_decoder.SetBatchViterbi(true);
+
+    const float Faudio = Fsymbol/5.0f;
+    auto audio_filter = AudioFilter((int)Faudio, Faudio);
+    auto frame_handler = FrameHandler(audio_filter);
+    frame_handler.is_output_audio = false;
+    auto audio_payloads = std::vector<uint8_t>();
+    const auto on_frame = [&frame_handler, &audio_payloads](auto res, const auto& payload) {
+        frame_handler.OnFrameResult(res, payload);
+        if ((res == FrameDecoder::ProcessResult::PAYLOAD_OK) && (payload.length == AUDIO_PACKET_BLOCK_SIZE)) {
+            audio_payloads.insert(audio_payloads.end(), payload.buf, payload.buf + payload.length);
+        }
+    };
+    // Payload results from both decoders are recorded in the order they are delivered
+    struct PayloadRecord {
+        FrameDecoder::ProcessResult res;
+        uint16_t length;
+        uint8_t crc8_received;
+    };
+    auto payloads = std::vector<PayloadRecord>();
+    auto ref_payloads = std::vector<PayloadRecord>();
+    const auto record_payload = [](std::vector<PayloadRecord>& records, auto res, const auto& payload) {
+        if ((res == FrameDecoder::ProcessResult::PAYLOAD_OK) || (res == FrameDecoder::ProcessResult::PAYLOAD_ERR)) {
+            records.push_back({ res, payload.length, payload.crc8_received });
+        }
+    };
+    const auto on_check_frame = [&payloads, &record_payload](auto res, const auto& payload) {
+        record_payload(payloads, res, payload);
+    };
+    const auto on_ref_frame = [&ref_payloads, &record_payload](auto res, const auto& payload) {
+        record_payload(ref_payloads, res, payload);
+    };
+    const auto process_audio = [&audio_filter, &audio_payloads]() {
+        for (size_t i = 0; i < audio_payloads.size(); i += AUDIO_PACKET_BLOCK_SIZE) {
+            audio_filter.ProcessFrame(&audio_payloads[i], AUDIO_PACKET_BLOCK_SIZE);
+        }
+        audio_payloads.clear();
+    };
+
+    auto res = Result();
+    res.config = config;
+    const uint64_t src_block_size = (uint64_t)buffer.GetInputSize();
+    const uint64_t total_blocks = (total_samples + src_block_size - 1) / src_block_size;
+    for (uint64_t i = 0; i < total_blocks; i++) {
+        rx_source->Read(buffer.x_raw);
+        int nb_symbols = 0;
+        res.dt_front_end += get_elapsed_ns([&]() { qam_sync.ProcessFrontEnd(buffer); });
+        res.dt_sync += get_elapsed_ns([&]() { nb_symbols = qam_sync.ProcessSync(buffer); });
+        res.dt_decoder += get_elapsed_ns([&]() { frame_decoder.process(buffer.y_out.first(nb_symbols), on_frame); });
+        res.dt_audio += get_elapsed_ns(process_audio);
+        res.total_symbols += nb_symbols;
+        if (is_batch_viterbi) {
+            for (int j = 0; j < nb_symbols; j += ORDER_CHECK_BLOCK_SIZE) {
+                const auto x = buffer.y_out.subspan(j, std::min(ORDER_CHECK_BLOCK_SIZE, nb_symbols-j));
+                check_frame_decoder.process(x, on_check_frame);
+                ref_frame_decoder.process(x, on_ref_frame);
+            }
+        }
+    }
+    res.dt_decoder += get_elapsed_ns([&]() { frame_decoder.Flush(on_frame); });
+    res.dt_audio += get_elapsed_ns(process_audio);
+
+    if (is_batch_viterbi) {
+        check_frame_decoder.Flush(on_check_frame);
+        res.batch_order_payloads = (int)ref_payloads.size();
+        const size_t nb_payloads = std::max(payloads.size(), ref_payloads.size());
+        for (size_t i = 0; i < nb_payloads; i++) {
+            const bool is_match = 
+                (i < payloads.size()) && (i < ref_payloads.size()) &&
+                (payloads[i].res == ref_payloads[i].res) &&
+                (payloads[i].length == ref_payloads[i].length) &&
+                (payloads[i].crc8_received == ref_payloads[i].crc8_received);
+            res.batch_order_mismatches += is_match ? 0 : 1;
+        }
+    }
+
+    res.total_samples = total_blocks * src_block_size;
+    res.frames_correct = frame_handler.stats.correct;
+    res.frames_incorrect = frame_handler.stats.incorrect;
+    return res;
+}
+
+std::vector<std::complex<uint8_t>> create_input_stream(
+    const IQ_Modulator& modulator, const ChannelSpecification* channel_spec,
+    const uint64_t total_samples)
+{
+    auto stream = std::vector<std::complex<uint8_t>>(total_samples);
+    if (channel_spec) {
+        auto channel = ChannelModel(*channel_spec, modulator);
+        auto rx_source = SimulatorSampleSource(channel);
+        rx_source.Read(stream);
+    } else {
+        auto rx_source = SimulatorSampleSource(modulator);
+        rx_source.Read(stream);
+    }
+    return stream;
+}
+
+// Times the App with the same settings as run_config from the start to the end of the stream
+double run_app(
+    tcb::span<const std::complex<uint8_t>> stream,
+    const float Fsample, const float Fsymbol, const Config& config,
+    const bool is_batch_viterbi, const bool is_pipelined, int& frames_correct)
+{
+    auto rx_source = MemorySampleSource(stream);
+    const int decoder_block_size = 1024;
+    const float Faudio = Fsymbol/5.0f;
+    const bool is_diagnostics = false;
+    auto app = App(
+        rx_source, config.block_size,
+        decoder_block_size, config.ds_factor, config.us_factor,
+        (int)Faudio, Faudio,
+        is_diagnostics);
+    app.qam_sync_spec = create_qam_sync_spec(Fsample, Fsymbol, config);
+    app.GetFrameHandler().is_output_audio = false;
+    app.GetFrameDecoder().SetBatchViterbi(is_batch_viterbi);
+    app.BuildDemodulator();
+
+    const double dt = get_elapsed_ns([&]() {
+        if (is_pipelined) {
+            app.RunPipelined();
+        } else {
+            app.Run();
+        }
+    });
+    frames_correct = app.GetFrameHandler().stats.correct;
+    return dt;
+}
+
+void write_json(FILE* fp, const std::vector<Result>& results, const float Fsample, const float Fsymbol, const bool is_batch_viterbi) {
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"sample_rate\": %.0f,\n", Fsample);
+    fprintf(fp, "  \"symbol_rate\": %.0f,\n", Fsymbol);
+    fprintf(fp, "  \"batch_viterbi\": %s,\n", is_batch_viterbi ? "true" : "false");
+    fprintf(fp, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& res = results[i];
+        const double N = (double)res.total_samples;
+        const double dt_total = res.GetTotalTime();
+        const double dt_seconds = dt_total * 1e-9;
+        fprintf(fp, "    {\n");
+        fprintf(fp, "      \"block_size\": %d,\n", res.config.block_size);
+        fprintf(fp, "      \"downsample_factor\": %d,\n", res.config.ds_factor);
+        fprintf(fp, "      \"upsample_factor\": %d,\n", res.config.us_factor);
+        fprintf(fp, "      \"total_samples\": %llu,\n", (unsigned long long)res.total_samples);
+        fprintf(fp, "      \"frames_correct\": %d,\n", res.frames_correct);
+        fprintf(fp, "      \"frames_incorrect\": %d,\n", res.frames_incorrect);
+        if (is_batch_viterbi) {
+            fprintf(fp, "      \"batch_order_mismatches\": %d,\n", res.batch_order_mismatches);
+        }
+        fprintf(fp, "      \"input_msps\": %.4f,\n", N / dt_seconds * 1e-6);
+        fprintf(fp, "      \"symbols_per_second\": %.1f,\n", (double)res.total_symbols / dt_seconds);
+        fprintf(fp, "      \"frames_per_second\": %.1f,\n", (double)(res.frames_correct + res.frames_incorrect) / dt_seconds);
+        fprintf(fp, "      \"real_time_factor\": %.3f,\n", N / (double)Fsample / dt_seconds);
+        fprintf(fp, "      \"ns_per_sample\": {\n");
+        fprintf(fp, "        \"front_end\": %.4f,\n", res.dt_front_end / N);
+        fprintf(fp, "        \"sync\": %.4f,\n", res.dt_sync / N);
+        fprintf(fp, "        \"decoder\": %.4f,\n", res.dt_decoder / N);
+        fprintf(fp, "        \"audio\": %.4f,\n", res.dt_audio / N);
+        fprintf(fp, "        \"total\": %.4f\n", dt_total / N);
+        fprintf(fp, "      },\n");
+        fprintf(fp, "      \"app\": {\n");
+        fprintf(fp, "        \"serial_msps\": %.4f,\n", N / res.dt_app_serial * 1e3);
+        fprintf(fp, "        \"pipelined_msps\": %.4f,\n", N / res.dt_app_pipelined * 1e3);
+        fprintf(fp, "        \"pipelined_speedup\": %.3f,\n", res.dt_app_serial / res.dt_app_pipelined);
+        fprintf(fp, "        \"serial_frames_correct\": %d,\n", res.app_frames_serial);
+        fprintf(fp, "        \"pipelined_frames_correct\": %d\n", res.app_frames_pipelined);
+        fprintf(fp, "      }\n");
+        fprintf(fp, "    }%s\n", (i+1 < results.size()) ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+}
@@ -0,0 +1,719 @@
+// Benchmark and cross check the scalar, SSSE3, AVX2 and AVX512 variants of the dsp/simd kernels
+// Each variant is timed over a range of lengths and offsets from an aligned address
+// Reports the throughput in GFLOP/s and the worst case error against the scalar variant
+// Errors are measured in ULPs of the magnitude of the terms so that cancellation doesn't inflate them
+// Reductions are summed in a different order so only element wise kernels are expected to be bit identical
+// Kernels with byte outputs must match the scalar variant exactly and count one operation per element
+// Exits with a non-zero code if any variant exceeds the error bound of its kernel
+// Variants the cpu does not support are skipped, set DSP_SIMD=scalar|ssse3|avx2|avx512 to skip more of them
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "dsp/simd/c32_f32_cum_mul.h"
+#include "dsp/simd/cu8_f32_cum_mul.h"
+#include "dsp/simd/f32_cum_mul.h"
+#include "dsp/simd/c32_mul.h"
+#include "dsp/simd/c32_cum_sum.h"
+#include "dsp/simd/f32_cum_sum.h"
+#include "dsp/simd/apply_harmonic_pll.h"
+#include "dsp/simd/c32_square_demap.h"
+#include "dsp/simd/u8_lut_pack.h"
+#include "dsp/simd/u8_xor.h"
+#include "dsp/simd/cpu_features.h"
+#include "utility/aligned_vector.h"
+#include "utility/getopt/getopt.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_simd, benchmarks and cross checks the SIMD variants of the dsp kernels\n\n"
+        "\t[-n number of elements processed for each measurement (default: 16777216)]\n"
+        "\t[-r number of repeats (default: 5)]\n"
+        "\t[-k only run the kernel with this name (default: all)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+// Shared arguments so all kernels can be called through the same function pointer
+struct Args {
+    const std::complex<uint8_t>* u0;
+    const std::complex<float>* c0;
+    const std::complex<float>* c1;
+    const float* f0;
+    const float* f1;
+    // 4 bit symbols and random bytes for the integer kernels
+    const uint8_t* s0;
+    const uint8_t* b0;
+    const uint8_t* b1;
+    std::complex<float>* y;
+    // byte outputs and the separate error outputs of the demapper
+    uint8_t* yb;
+    float* e0;
+    float* e1;
+    int N;
+};
+
+// Reductions return their result and element wise kernels write to y
+typedef std::complex<float> (*KernelFunction)(const Args&);
+
+struct Variant {
+    const char* name;
+    KernelFunction func;
+    // variants the cpu doesn't support are skipped
+    DSP_SIMD_Level level;
+};
+
+struct Kernel {
+    const char* name;
+    std::vector<Variant> variants;
+    // nominal floating point operations per element
+    double flops_per_element;
+    // bound on the error against the scalar variant in ULPs for N elements
+    double (*get_ulp_bound)(const int N);
+    bool is_reduction;
+    bool is_aligned_only;
+    // compare the byte outputs in yb instead of y
+    bool is_byte_output = false;
+};
+
+// Harmonic pll reference signal
+constexpr float PLL_HARMONIC = 2.0f*3.14159265358979323846f*4.0f;
+constexpr float PLL_OFFSET = 0.3f;
+// Square constellation with 4 points per axis like 16-QAM
+static const SquareDemapParams DEMAP_PARAMS = { 4, 2, 1.5f, 2.0f/3.0f };
+// Permutation of the 4 bit symbols (7*i+3) % 16
+static const uint8_t PACK_LUT[16] = { 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9, 0, 7, 14, 5, 12 };
+
+// c32_f32_cum_mul
+static std::complex<float> run_c32_f32_cum_mul_scalar(const Args& a) { return c32_f32_cum_mul_scalar(a.c0, a.f1, a.N); }
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_c32_f32_cum_mul_ssse3(const Args& a) { return c32_f32_cum_mul_ssse3(a.c0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_c32_f32_cum_mul_avx2(const Args& a) { return c32_f32_cum_mul_avx2(a.c0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_c32_f32_cum_mul_avx512(const Args& a) { return c32_f32_cum_mul_avx512(a.c0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+
+// cu8_f32_cum_mul
+static std::complex<float> run_cu8_f32_cum_mul_scalar(const Args& a) { return cu8_f32_cum_mul_scalar(a.u0, a.f1, a.N); }
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_cu8_f32_cum_mul_ssse3(const Args& a) { return cu8_f32_cum_mul_ssse3(a.u0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_cu8_f32_cum_mul_avx2(const Args& a) { return cu8_f32_cum_mul_avx2(a.u0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_cu8_f32_cum_mul_avx512(const Args& a) { return cu8_f32_cum_mul_avx512(a.u0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+
+// f32_cum_mul
+static std::complex<float> run_f32_cum_mul_scalar(const Args& a) { return f32_cum_mul_scalar(a.f0, a.f1, a.N); }
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_f32_cum_mul_ssse3(const Args& a) { return f32_cum_mul_ssse3(a.f0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_f32_cum_mul_avx2(const Args& a) { return f32_cum_mul_avx2(a.f0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_f32_cum_mul_avx512(const Args& a) { return f32_cum_mul_avx512(a.f0, a.f1, a.N); }
+DSP_TARGET_END
+#endif
+
+// c32_mul only operates on registers so it is applied element wise over the arrays
+static std::complex<float> run_c32_mul_scalar(const Args& a) {
+    for (int i = 0; i < a.N; i++) {
+        a.y[i] = a.c0[i] * a.c1[i];
+    }
+    return a.y[0];
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_c32_mul_ssse3(const Args& a) {
+    constexpr int K = 2;
+    const int M = a.N/K;
+    for (int i = 0; i < M; i++) {
+        const __m128 x0 = _mm_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K]));
+        const __m128 x1 = _mm_loadu_ps(reinterpret_cast<const float*>(&a.c1[i*K]));
+        _mm_storeu_ps(reinterpret_cast<float*>(&a.y[i*K]), c32_mul_ssse3(x0, x1));
+    }
+    for (int i = M*K; i < a.N; i++) {
+        a.y[i] = a.c0[i] * a.c1[i];
+    }
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_c32_mul_avx2(const Args& a) {
+    constexpr int K = 4;
+    const int M = a.N/K;
+    for (int i = 0; i < M; i++) {
+        const __m256 x0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K]));
+        const __m256 x1 = _mm256_loadu_ps(reinterpret_cast<const float*>(&a.c1[i*K]));
+        _mm256_storeu_ps(reinterpret_cast<float*>(&a.y[i*K]), c32_mul_avx2(x0, x1));
+    }
+    for (int i = M*K; i < a.N; i++) {
+        a.y[i] = a.c0[i] * a.c1[i];
+    }
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_c32_mul_avx512(const Args& a) {
+    constexpr int K = 8;
+    const int M = a.N/K;
+    for (int i = 0; i < M; i++) {
+        const __m512 x0 = _mm512_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K]));
+        const __m512 x1 = _mm512_loadu_ps(reinterpret_cast<const float*>(&a.c1[i*K]));
+        _mm512_storeu_ps(reinterpret_cast<float*>(&a.y[i*K]), c32_mul_avx512(x0, x1));
+    }
+    for (int i = M*K; i < a.N; i++) {
+        a.y[i] = a.c0[i] * a.c1[i];
+    }
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+
+// c32_cum_sum only reduces a register so the arrays are summed into a register first
+static std::complex<float> run_c32_cum_sum_scalar(const Args& a) {
+    auto y = std::complex<float>(0,0);
+    for (int i = 0; i < a.N; i++) {
+        y += a.c0[i];
+    }
+    return y;
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_c32_cum_sum_ssse3(const Args& a) {
+    constexpr int K = 2;
+    const int M = a.N/K;
+    cpx128_t v_sum;
+    v_sum.ps = _mm_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm_add_ps(v_sum.ps, _mm_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K])));
+    }
+    auto y = c32_cum_sum_ssse3(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.c0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_c32_cum_sum_avx2(const Args& a) {
+    constexpr int K = 4;
+    const int M = a.N/K;
+    cpx256_t v_sum;
+    v_sum.ps = _mm256_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm256_add_ps(v_sum.ps, _mm256_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K])));
+    }
+    auto y = c32_cum_sum_avx2(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.c0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_c32_cum_sum_avx512(const Args& a) {
+    constexpr int K = 8;
+    const int M = a.N/K;
+    cpx512_t v_sum;
+    v_sum.ps = _mm512_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm512_add_ps(v_sum.ps, _mm512_loadu_ps(reinterpret_cast<const float*>(&a.c0[i*K])));
+    }
+    auto y = c32_cum_sum_avx512(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.c0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+
+// f32_cum_sum only reduces a register so the arrays are summed into a register first
+static std::complex<float> run_f32_cum_sum_scalar(const Args& a) {
+    float y = 0.0f;
+    for (int i = 0; i < a.N; i++) {
+        y += a.f0[i];
+    }
+    return y;
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_f32_cum_sum_ssse3(const Args& a) {
+    constexpr int K = 4;
+    const int M = a.N/K;
+    cpx128_t v_sum;
+    v_sum.ps = _mm_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm_add_ps(v_sum.ps, _mm_loadu_ps(&a.f0[i*K]));
+    }
+    float y = f32_cum_sum_ssse3(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.f0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_f32_cum_sum_avx2(const Args& a) {
+    constexpr int K = 8;
+    const int M = a.N/K;
+    cpx256_t v_sum;
+    v_sum.ps = _mm256_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm256_add_ps(v_sum.ps, _mm256_loadu_ps(&a.f0[i*K]));
+    }
+    float y = f32_cum_sum_avx2(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.f0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_f32_cum_sum_avx512(const Args& a) {
+    constexpr int K = 16;
+    const int M = a.N/K;
+    cpx512_t v_sum;
+    v_sum.ps = _mm512_set1_ps(0.0f);
+    for (int i = 0; i < M; i++) {
+        v_sum.ps = _mm512_add_ps(v_sum.ps, _mm512_loadu_ps(&a.f0[i*K]));
+    }
+    float y = f32_cum_sum_avx512(v_sum);
+    for (int i = M*K; i < a.N; i++) {
+        y += a.f0[i];
+    }
+    return y;
+}
+DSP_TARGET_END
+#endif
+
+// apply_harmonic_pll
+static std::complex<float> run_apply_harmonic_pll_scalar(const Args& a) {
+    apply_harmonic_pll_scalar(a.f0, a.c0, a.y, a.N, PLL_HARMONIC, PLL_OFFSET);
+    return a.y[0];
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_apply_harmonic_pll_ssse3(const Args& a) {
+    apply_harmonic_pll_ssse3(a.f0, a.c0, a.y, a.N, PLL_HARMONIC, PLL_OFFSET);
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_apply_harmonic_pll_avx2(const Args& a) {
+    apply_harmonic_pll_avx2(a.f0, a.c0, a.y, a.N, PLL_HARMONIC, PLL_OFFSET);
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static std::complex<float> run_apply_harmonic_pll_avx512(const Args& a) {
+    apply_harmonic_pll_avx512(a.f0, a.c0, a.y, a.N, PLL_HARMONIC, PLL_OFFSET);
+    return a.y[0];
+}
+DSP_TARGET_END
+#endif
+
+// c32_square_demap with only the gray coded symbols
+static std::complex<float> run_c32_square_demap_scalar(const Args& a) {
+    c32_square_demap_scalar(a.c0, a.yb, NULL, NULL, a.N, DEMAP_PARAMS);
+    return (float)a.yb[0];
+}
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_c32_square_demap_avx2(const Args& a) {
+    c32_square_demap_avx2(a.c0, a.yb, NULL, NULL, a.N, DEMAP_PARAMS);
+    return (float)a.yb[0];
+}
+DSP_TARGET_END
+#endif
+
+// c32_square_demap with the magnitude and phase errors which are packed into y as (mag, phase)
+static std::complex<float> pack_demap_errors(const Args& a) {
+    for (int i = 0; i < a.N; i++) {
+        a.y[i] = { a.e0[i], a.e1[i] };
+    }
+    return a.y[0];
+}
+static std::complex<float> run_c32_square_demap_error_scalar(const Args& a) {
+    c32_square_demap_scalar(a.c0, a.yb, a.e0, a.e1, a.N, DEMAP_PARAMS);
+    return pack_demap_errors(a);
+}
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_c32_square_demap_error_avx2(const Args& a) {
+    c32_square_demap_avx2(a.c0, a.yb, a.e0, a.e1, a.N, DEMAP_PARAMS);
+    return pack_demap_errors(a);
+}
+DSP_TARGET_END
+#endif
+
+// u8_lut_pack only has SIMD variants for 4 bit symbols so odd lengths are rounded down to whole bytes
+static std::complex<float> run_u8_lut_pack_scalar(const Args& a) {
+    u8_lut_pack_nibble_scalar(a.s0, a.yb, PACK_LUT, a.N & ~1);
+    return (float)a.yb[0];
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_u8_lut_pack_ssse3(const Args& a) {
+    u8_lut_pack_nibble_ssse3(a.s0, a.yb, PACK_LUT, a.N & ~1);
+    return (float)a.yb[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_u8_lut_pack_avx2(const Args& a) {
+    u8_lut_pack_nibble_avx2(a.s0, a.yb, PACK_LUT, a.N & ~1);
+    return (float)a.yb[0];
+}
+DSP_TARGET_END
+#endif
+
+// u8_xor
+static std::complex<float> run_u8_xor_scalar(const Args& a) {
+    u8_xor_scalar(a.b0, a.b1, a.yb, a.N);
+    return (float)a.yb[0];
+}
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static std::complex<float> run_u8_xor_ssse3(const Args& a) {
+    u8_xor_ssse3(a.b0, a.b1, a.yb, a.N);
+    return (float)a.yb[0];
+}
+DSP_TARGET_END
+#endif
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static std::complex<float> run_u8_xor_avx2(const Args& a) {
+    u8_xor_avx2(a.b0, a.b1, a.yb, a.N);
+    return (float)a.yb[0];
+}
+DSP_TARGET_END
+#endif
+
+// Rounding errors from summing in a different order grow like a random walk instead of the worst case of N ULPs
+// The worst case bound is too loose to catch a dropped element so the inputs are fixed and this bound is used instead
+static double get_reduction_ulp_bound(const int N) { return 4.0*std::sqrt((double)N) + 8.0; }
+// Products of complex numbers are rounded twice and fused multiply adds may skip one of them
+static double get_c32_mul_ulp_bound(const int N) { (void)N; return 4.0; }
+// cos/sin approximations lose accuracy with the size of the argument which is at most 8pi here
+static double get_pll_ulp_bound(const int N) { (void)N; return 64.0; }
+// Demapper errors are measured against a magnitude of 1 where the atan2 approximation is accurate to 1e-5 radians
+static double get_demap_ulp_bound(const int N) { (void)N; return 1e-5 / (double)FLT_EPSILON; }
+// Byte outputs have no rounding so the bound is on the absolute difference of each byte
+static double get_exact_ulp_bound(const int N) { (void)N; return 0.0; }
+
+#if defined(_DSP_BUILD_AVX512)
+#define ADD_AVX512_VARIANT(name) { "avx512", run_##name##_avx512, DSP_SIMD_Level::AVX512 },
+#else
+#define ADD_AVX512_VARIANT(name)
+#endif
+#if defined(_DSP_BUILD_AVX2)
+#define ADD_AVX2_VARIANT(name) { "avx2", run_##name##_avx2, DSP_SIMD_Level::AVX2 },
+#else
+#define ADD_AVX2_VARIANT(name)
+#endif
+#if defined(_DSP_BUILD_SSSE3)
+#define ADD_SSSE3_VARIANT(name) { "ssse3", run_##name##_ssse3, DSP_SIMD_Level::SSSE3 },
+#else
+#define ADD_SSSE3_VARIANT(name)
+#endif
+// scalar variant must come first since it is the reference
+#define GET_VARIANTS(name) { { "scalar", run_##name##_scalar, DSP_SIMD_Level::SCALAR }, ADD_SSSE3_VARIANT(name) ADD_AVX2_VARIANT(name) ADD_AVX512_VARIANT(name) }
+#define GET_VARIANTS_UPTO_AVX2(name) { { "scalar", run_##name##_scalar, DSP_SIMD_Level::SCALAR }, ADD_SSSE3_VARIANT(name) ADD_AVX2_VARIANT(name) }
+#define GET_VARIANTS_ONLY_AVX2(name) { { "scalar", run_##name##_scalar, DSP_SIMD_Level::SCALAR }, ADD_AVX2_VARIANT(name) }
+
+std::vector<Kernel> create_kernels() {
+    auto kernels = std::vector<Kernel>();
+    kernels.push_back({ "c32_f32_cum_mul", GET_VARIANTS(c32_f32_cum_mul), 4.0, get_reduction_ulp_bound, true, false });
+    kernels.push_back({ "cu8_f32_cum_mul", GET_VARIANTS(cu8_f32_cum_mul), 4.0, get_reduction_ulp_bound, true, false });
+    kernels.push_back({ "f32_cum_mul", GET_VARIANTS(f32_cum_mul), 2.0, get_reduction_ulp_bound, true, false });
+    kernels.push_back({ "c32_mul", GET_VARIANTS(c32_mul), 6.0, get_c32_mul_ulp_bound, false, false });
+    kernels.push_back({ "c32_cum_sum", GET_VARIANTS(c32_cum_sum), 2.0, get_reduction_ulp_bound, true, false });
+    kernels.push_back({ "f32_cum_sum", GET_VARIANTS(f32_cum_sum), 1.0, get_reduction_ulp_bound, true, false });
+    // complex multiply + phase calculation, the cos/sin evaluation is not counted
+    // NOTE: The SIMD variants use aligned loads and stores
+    kernels.push_back({ "apply_harmonic_pll", GET_VARIANTS(apply_harmonic_pll), 10.0, get_pll_ulp_bound, false, true });
+    // quantise, clamp and round both axes then gray code them into the symbol
+    kernels.push_back({ "c32_square_demap", GET_VARIANTS_ONLY_AVX2(c32_square_demap), 12.0, get_exact_ulp_bound, false, false, true });
+    // also the distance and rotation from the nearest point, the sqrt and atan2 evaluation are not counted
+    kernels.push_back({ "c32_square_demap_error", GET_VARIANTS_ONLY_AVX2(c32_square_demap_error), 21.0, get_demap_ulp_bound, false, false });
+    kernels.push_back({ "u8_lut_pack", GET_VARIANTS_UPTO_AVX2(u8_lut_pack), 1.0, get_exact_ulp_bound, false, false, true });
+    kernels.push_back({ "u8_xor", GET_VARIANTS_UPTO_AVX2(u8_xor), 1.0, get_exact_ulp_bound, false, false, true });
+    return kernels;
+}
+
+#undef GET_VARIANTS
+#undef GET_VARIANTS_UPTO_AVX2
+#undef GET_VARIANTS_ONLY_AVX2
+#undef ADD_SSSE3_VARIANT
+#undef ADD_AVX2_VARIANT
+#undef ADD_AVX512_VARIANT
+
+// Size of one unit in the last place for a float of this magnitude
+static double get_ulp(const double x) {
+    const double v = std::max(std::abs(x), (double)FLT_MIN);
+    return std::ldexp(1.0, std::ilogb(v) - 23);
+}
+
+static double get_ulp_error(const std::complex<float> y, const std::complex<float> y_ref, const double magnitude) {
+    const double ulp = get_ulp(magnitude);
+    const double I = std::abs((double)y.real() - (double)y_ref.real());
+    const double Q = std::abs((double)y.imag() - (double)y_ref.imag());
+    return std::max(I, Q) / ulp;
+}
+
+// Magnitude of the terms which make up each output
+static double get_term_magnitude(const Kernel& kernel, const Args& a, const int i) {
+    const std::string name = kernel.name;
+    if (name == "c32_f32_cum_mul") return std::abs(a.c0[i]) * std::abs(a.f1[i]);
+    if (name == "cu8_f32_cum_mul") {
+        const auto x = std::complex<float>((float)a.u0[i].real() - 128.0f, (float)a.u0[i].imag() - 128.0f);
+        return std::abs(x) * std::abs(a.f1[i]);
+    }
+    if (name == "f32_cum_mul") return std::abs(a.f0[i] * a.f1[i]);
+    if (name == "c32_mul") return std::abs(a.c0[i]) * std::abs(a.c1[i]);
+    if (name == "c32_cum_sum") return std::abs(a.c0[i]);
+    if (name == "f32_cum_sum") return std::abs(a.f0[i]);
+    if (name == "c32_square_demap_error") return 1.0;
+    return std::abs(a.c0[i]);
+}
+
+static bool is_bit_identical(const std::complex<float> y, const std::complex<float> y_ref) {
+    return memcmp(&y, &y_ref, sizeof(y)) == 0;
+}
+
+template <typename F>
+double get_best_time(F&& func, const int nb_repeats) {
+    double dt_best = INFINITY;
+    for (int r = 0; r < nb_repeats; r++) {
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        func();
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        const double dt = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        dt_best = (dt < dt_best) ? dt : dt_best;
+    }
+    return dt_best;
+}
+
+int main(int argc, char** argv) {
+    int nb_total_elements = 1 << 24;
+    int nb_repeats = 5;
+    const char* kernel_filter = NULL;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "n:r:k:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            nb_total_elements = (int)(atof(optarg));
+            if (nb_total_elements <= 0) {
+                fprintf(stderr, "Number of elements must be positive (%d)\n", nb_total_elements);
+                return 1;
+            }
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'k':
+            kernel_filter = optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    const int lengths[] = { 7, 16, 61, 256, 1024, 4099, 16384, 65536 };
+    // offsets in elements from a 32 byte aligned address
+    const int offsets[] = { 0, 1, 3 };
+    constexpr int MAX_OFFSET = 4;
+    const int max_length = *std::max_element(std::begin(lengths), std::end(lengths));
+    const int max_buffer = max_length + MAX_OFFSET;
+
+    auto u0 = AlignedVector<std::complex<uint8_t>>(max_buffer);
+    auto c0 = AlignedVector<std::complex<float>>(max_buffer);
+    auto c1 = AlignedVector<std::complex<float>>(max_buffer);
+    auto f0 = AlignedVector<float>(max_buffer);
+    auto f1 = AlignedVector<float>(max_buffer);
+    auto y_ref = AlignedVector<std::complex<float>>(max_buffer);
+    auto y = AlignedVector<std::complex<float>>(max_buffer);
+    auto s0 = AlignedVector<uint8_t>(max_buffer);
+    auto b0 = AlignedVector<uint8_t>(max_buffer);
+    auto b1 = AlignedVector<uint8_t>(max_buffer);
+    auto yb_ref = AlignedVector<uint8_t>(max_buffer);
+    auto yb = AlignedVector<uint8_t>(max_buffer);
+    auto e0 = AlignedVector<float>(max_buffer);
+    auto e1 = AlignedVector<float>(max_buffer);
+    {
+        auto rng = std::mt19937(1234);
+        auto dist = std::uniform_real_distribution<float>(-1.0f, 1.0f);
+        auto time_dist = std::uniform_real_distribution<float>(0.0f, 1.0f);
+        for (int i = 0; i < max_buffer; i++) {
+            c0[i] = { dist(rng), dist(rng) };
+            c1[i] = { dist(rng), dist(rng) };
+            // also used as the time vector of the harmonic pll
+            f0[i] = time_dist(rng);
+            f1[i] = dist(rng);
+        }
+        auto u8_dist = std::uniform_int_distribution<int>(0, 255);
+        for (int i = 0; i < max_buffer; i++) {
+            u0[i] = { (uint8_t)u8_dist(rng), (uint8_t)u8_dist(rng) };
+            s0[i] = (uint8_t)(u8_dist(rng) & 0x0F);
+            b0[i] = (uint8_t)u8_dist(rng);
+            b1[i] = (uint8_t)u8_dist(rng);
+        }
+    }
+
+    const auto kernels = create_kernels();
+    const auto simd_level = dsp_get_simd_level();
+    fprintf(stdout, "cpu simd level: %s\n", get_dsp_simd_level_string(simd_level));
+    bool is_all_ok = true;
+    fprintf(stdout, "%-24s %-8s %8s %8s %10s %10s %10s %8s %6s\n", "kernel", "variant", "length", "offset", "GFLOP/s", "max_ulp", "ulp_bound", "exact%", "check");
+    for (const auto& kernel: kernels) {
+        if ((kernel_filter != NULL) && (std::string(kernel_filter) != kernel.name)) {
+            continue;
+        }
+        for (const int N: lengths) {
+            for (const int offset: offsets) {
+                if (kernel.is_aligned_only && (offset != 0)) {
+                    continue;
+                }
+                Args args;
+                args.u0 = &u0[offset];
+                args.c0 = &c0[offset];
+                args.c1 = &c1[offset];
+                args.f0 = &f0[offset];
+                args.f1 = &f1[offset];
+                args.s0 = &s0[offset];
+                args.b0 = &b0[offset];
+                args.b1 = &b1[offset];
+                args.e0 = &e0[offset];
+                args.e1 = &e1[offset];
+                args.N = N;
+                args.y = &y_ref[offset];
+                args.yb = &yb_ref[offset];
+                // some kernels write fewer bytes than elements so the rest is cleared to compare equal
+                memset(args.yb, 0, N);
+                const auto res_ref = kernel.variants[0].func(args);
+
+                // error is relative to the sum of the term magnitudes for reductions and per element otherwise
+                double reduction_magnitude = 0.0;
+                for (int i = 0; i < N; i++) {
+                    reduction_magnitude += get_term_magnitude(kernel, args, i);
+                }
+                const double ulp_bound = kernel.get_ulp_bound(N);
+                const int nb_calls = std::max(1, nb_total_elements / N);
+
+                for (const auto& variant: kernel.variants) {
+                    if (variant.level > simd_level) {
+                        continue;
+                    }
+                    args.y = &y[offset];
+                    args.yb = &yb[offset];
+                    memset(args.yb, 0, N);
+                    const auto res = variant.func(args);
+                    double max_ulp = 0.0;
+                    // fraction of outputs which are bit identical to the scalar variant
+                    double exact = 0.0;
+                    if (kernel.is_reduction) {
+                        max_ulp = get_ulp_error(res, res_ref, reduction_magnitude);
+                        exact = is_bit_identical(res, res_ref) ? 1.0 : 0.0;
+                    } else if (kernel.is_byte_output) {
+                        int nb_exact = 0;
+                        for (int i = 0; i < N; i++) {
+                            const int diff = std::abs((int)args.yb[i] - (int)yb_ref[offset+i]);
+                            max_ulp = std::max(max_ulp, (double)diff);
+                            nb_exact += (diff == 0) ? 1 : 0;
+                        }
+                        exact = (double)nb_exact / (double)N;
+                    } else {
+                        int nb_exact = 0;
+                        for (int i = 0; i < N; i++) {
+                            const double magnitude = get_term_magnitude(kernel, args, i);
+                            max_ulp = std::max(max_ulp, get_ulp_error(args.y[i], y_ref[offset+i], magnitude));
+                            nb_exact += is_bit_identical(args.y[i], y_ref[offset+i]) ? 1 : 0;
+                        }
+                        exact = (double)nb_exact / (double)N;
+                    }
+
+                    auto sink = std::complex<float>(0,0);
+                    const double dt = get_best_time([&]() {
+                        for (int i = 0; i < nb_calls; i++) {
+                            sink += variant.func(args);
+                        }
+                    }, nb_repeats);
+                    // Prevent the calls from being optimised away
+                    if (std::abs(sink) < 0.0f) {
+                        fprintf(stderr, "unreachable\n");
+                    }
+
+                    const double gflops = kernel.flops_per_element * (double)N * (double)nb_calls / dt;
+                    const bool is_ok = max_ulp <= ulp_bound;
+                    is_all_ok = is_all_ok && is_ok;
+                    fprintf(stdout, "%-24s %-8s %8d %8d %10.3f %10.2f %10.0f %8.1f %6s\n",
+                        kernel.name, variant.name, N, offset, gflops, max_ulp, ulp_bound, exact*100.0, is_ok ? "ok" : "FAIL");
+                }
+            }
+        }
+    }
+
+    if (!is_all_ok) {
+        fprintf(stderr, "Some variants exceeded the error bound against the scalar reference\n");
+        return 1;
+    }
+    return 0;
+}
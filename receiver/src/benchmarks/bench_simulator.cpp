@@ -0,0 +1,216 @@
+// Benchmark the transmitter simulator for different modulations and samples per symbol
+// Compares the fused block modulator against a per symbol and per sample loop
+// Reports the frame encoding throughput in MB/s and the IQ output in MS/s
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "simulator/frame_encoder.h"
+#include "simulator/iq_modulator.h"
+#include "utility/getopt/getopt.h"
+#include "utility/span.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_simulator, benchmarks the frame encoder and IQ modulator of the transmitter\n\n"
+        "\t[-n number of output samples (default: 16777216)]\n"
+        "\t[-b block size (default: 4096)]\n"
+        "\t[-p payload size of each frame (default: 100)]\n"
+        "\t[-r number of repeats (default: 5)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+struct Result {
+    double mega_per_second;
+    bool is_match;
+};
+
+// Callable is run once per repeat and the best time is used
+template <typename F>
+double get_best_time(F&& func, const int nb_repeats) {
+    double dt_best = INFINITY;
+    for (int r = 0; r < nb_repeats; r++) {
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        func();
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        const double dt = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        dt_best = (dt < dt_best) ? dt : dt_best;
+    }
+    return dt_best;
+}
+
+std::vector<uint8_t> create_frames(const int nb_frames, const int nb_payload_bytes, double& mbytes_per_second, const int nb_repeats) {
+    auto rng = std::mt19937(1234);
+    auto byte_dist = std::uniform_int_distribution<int>(0, 255);
+    auto payload = std::vector<uint8_t>(nb_payload_bytes);
+    for (auto& v: payload) {
+        v = (uint8_t)byte_dist(rng);
+    }
+
+    const int nb_encoded_bytes = FrameEncoder::GetEncodedSize(nb_payload_bytes);
+    auto encoded = std::vector<uint8_t>(nb_encoded_bytes*nb_frames);
+    auto encoder = FrameEncoder();
+    const double dt = get_best_time([&]() {
+        for (int i = 0; i < nb_frames; i++) {
+            // change the payload so each frame is different
+            payload[0] = (uint8_t)i;
+            encoder.CreateFrame(payload, { &encoded[i*nb_encoded_bytes], (size_t)nb_encoded_bytes });
+        }
+    }, nb_repeats);
+    mbytes_per_second = (double)encoded.size() / dt * 1e3;
+    return encoded;
+}
+
+// Same as the original transmitter loop which maps each byte and writes one sample at a time
+void modulate_per_sample(
+    tcb::span<const uint8_t> data, const ModulationType modulation, const int samples_per_symbol,
+    tcb::span<uint8_t> iq)
+{
+    const int A = 64;
+    const int B = 128;
+    const uint8_t gray_code[4] = {0b00, 0b01, 0b11, 0b10};
+    uint8_t I[4], Q[4];
+    size_t curr_byte = 0;
+    size_t j = 0;
+    while (1) {
+        const uint8_t x = data[curr_byte];
+        curr_byte = (curr_byte+1) % data.size();
+        int total_symbols = 0;
+        if (modulation == ModulationType::QAM16) {
+            const int DC = (int)((float)A * 1.5f);
+            for (int k = 0; k < 2; k++) {
+                I[k] = (uint8_t)(gray_code[(x >> (6-4*k)) & 0b11]*A + B - DC);
+                Q[k] = (uint8_t)(gray_code[(x >> (4-4*k)) & 0b11]*A + B - DC);
+            }
+            total_symbols = 2;
+        } else {
+            const int DC = A/2;
+            for (int k = 0; k < 4; k++) {
+                I[k] = (uint8_t)(((x >> (7-2*k)) & 0b1)*A + B - DC);
+                Q[k] = (uint8_t)(((x >> (6-2*k)) & 0b1)*A + B - DC);
+            }
+            total_symbols = 4;
+        }
+
+        for (int k = 0; k < total_symbols; k++) {
+            for (int n = 0; n < samples_per_symbol; n++) {
+                iq[j  ] = I[k];
+                iq[j+1] = Q[k];
+                j += 2;
+                if (j >= iq.size()) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+Result run_modulator(
+    tcb::span<const uint8_t> data, const ModulationType modulation, const int samples_per_symbol,
+    const int nb_samples, const int block_size, const int nb_repeats,
+    tcb::span<const uint8_t> expected)
+{
+    auto modulator = IQ_Modulator(modulation, samples_per_symbol);
+    modulator.SetData(data);
+    auto iq = std::vector<uint8_t>(nb_samples*2);
+    const double dt = get_best_time([&]() {
+        for (int i = 0; i < nb_samples; i += block_size) {
+            const int N = ((nb_samples-i) < block_size) ? (nb_samples-i) : block_size;
+            modulator.Generate({ &iq[i*2], (size_t)(N*2) }, (uint64_t)i);
+        }
+    }, nb_repeats);
+
+    Result res;
+    res.mega_per_second = (double)nb_samples / dt * 1e3;
+    res.is_match = memcmp(iq.data(), expected.data(), iq.size()) == 0;
+    return res;
+}
+
+double run_per_sample(
+    tcb::span<const uint8_t> data, const ModulationType modulation, const int samples_per_symbol,
+    const int nb_samples, const int nb_repeats,
+    std::vector<uint8_t>& iq)
+{
+    iq.resize(nb_samples*2);
+    const double dt = get_best_time([&]() {
+        modulate_per_sample(data, modulation, samples_per_symbol, iq);
+    }, nb_repeats);
+    return (double)nb_samples / dt * 1e3;
+}
+
+int main(int argc, char** argv) {
+    int nb_samples = 1 << 24;
+    int block_size = 4096;
+    int nb_payload_bytes = 100;
+    int nb_repeats = 5;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "n:b:p:r:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            nb_samples = (int)(atof(optarg));
+            if (nb_samples <= 0) {
+                fprintf(stderr, "Number of samples must be positive (%d)\n", nb_samples);
+                return 1;
+            }
+            break;
+        case 'b':
+            block_size = (int)(atof(optarg));
+            if (block_size <= 0) {
+                fprintf(stderr, "Block size must be positive (%d)\n", block_size);
+                return 1;
+            }
+            break;
+        case 'p':
+            nb_payload_bytes = (int)(atof(optarg));
+            if ((nb_payload_bytes <= 0) || (nb_payload_bytes > FrameEncoder::MAX_PAYLOAD_SIZE)) {
+                fprintf(stderr, "Payload size must be between 1 and %d (%d)\n", FrameEncoder::MAX_PAYLOAD_SIZE, nb_payload_bytes);
+                return 1;
+            }
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    constexpr int TOTAL_FRAMES = 1000;
+    double encode_mbytes_per_second = 0.0;
+    const auto data = create_frames(TOTAL_FRAMES, nb_payload_bytes, encode_mbytes_per_second, nb_repeats);
+    fprintf(stdout, "frame_encoder payload=%d: %.2f MB/s\n\n", nb_payload_bytes, encode_mbytes_per_second);
+
+    struct Modulation {
+        const char* name;
+        ModulationType type;
+    };
+    const Modulation modulations[] = { { "16qam", ModulationType::QAM16 }, { "4qam", ModulationType::QPSK } };
+    const int samples_per_symbol[] = { 1, 2, 4, 5, 8, 10, 16, 20, 40 };
+
+    fprintf(stdout, "%-12s %8s %14s %14s %8s\n", "modulation", "Nsps", "per_sample", "fused", "check");
+    std::vector<uint8_t> expected;
+    for (const auto& modulation: modulations) {
+        for (const int Nsps: samples_per_symbol) {
+            const double ref = run_per_sample(data, modulation.type, Nsps, nb_samples, nb_repeats, expected);
+            const auto res = run_modulator(data, modulation.type, Nsps, nb_samples, block_size, nb_repeats, expected);
+            fprintf(stdout, "%-12s %8d %9.2f MS/s %9.2f MS/s %8s\n",
+                modulation.name, Nsps, ref, res.mega_per_second,
+                res.is_match ? "ok" : "MISMATCH");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,317 @@
+// Benchmark the viterbi decoders for different constraint lengths and code rates
+// Random data is encoded, corrupted with random bit errors and then decoded
+// Reports the decoded throughput in Mbit/s and the bit error rate after decoding
+// The batch decoder is also compared frame by frame against the single frame decoder
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+#include "decoder/convolutional_encoder.h"
+#include "decoder/generic_viterbi_decoder.h"
+#include "decoder/streaming_viterbi_decoder.h"
+#include "decoder/viterbi_decoder.h"
+#include "decoder/batch_viterbi_decoder.h"
+#include "decoder/hard_decision_viterbi_decoder.h"
+#include "utility/getopt/getopt.h"
+#include "utility/span.h"
+
+void usage() {
+    fprintf(stderr,
+        "bench_viterbi, benchmarks the viterbi decoders for different codes\n\n"
+        "\t[-n number of decoded bits (default: 1048576)]\n"
+        "\t[-p probability of an encoded bit error (default: 0.01)]\n"
+        "\t[-f number of bytes per frame for the batch decoder (default: 32)]\n"
+        "\t[-r number of repeats (default: 5)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+struct Result {
+    double mbit_per_second;
+    double bit_error_rate;
+};
+
+struct TestData {
+    std::vector<uint8_t> x;
+    std::vector<uint8_t> y;
+};
+
+// Encoded data has a null byte at the end to terminate the trellis back into the zero state
+template <int K, int R>
+TestData create_test_data(const uint16_t poly[R], const int nb_bytes, const float p_error) {
+    auto enc = ConvolutionalEncoder<K,R>(poly);
+    auto rng = std::mt19937(1234);
+    auto byte_dist = std::uniform_int_distribution<int>(0, 255);
+    auto error_dist = std::bernoulli_distribution(p_error);
+
+    TestData data;
+    data.x.resize(nb_bytes);
+    data.y.resize((nb_bytes+1)*R);
+    for (auto& v: data.x) {
+        v = (uint8_t)byte_dist(rng);
+    }
+
+    int offset = 0;
+    for (auto& v: data.x) {
+        offset += enc.consume_byte(v, &data.y[offset]);
+    }
+    offset += enc.consume_byte(0x00, &data.y[offset]);
+
+    for (auto& v: data.y) {
+        for (int i = 0; i < 8; i++) {
+            if (error_dist(rng)) {
+                v ^= (uint8_t)(1u << i);
+            }
+        }
+    }
+    return data;
+}
+
+// Each frame is encoded separately with its own null terminator like the receiver's payloads
+TestData create_frame_test_data(const uint16_t poly[2], const int nb_frames, const int nb_frame_bytes, const float p_error) {
+    auto enc = ConvolutionalEncoder<3,2>(poly);
+    auto rng = std::mt19937(1234);
+    auto byte_dist = std::uniform_int_distribution<int>(0, 255);
+    auto error_dist = std::bernoulli_distribution(p_error);
+
+    TestData data;
+    data.x.resize(nb_frames*nb_frame_bytes);
+    data.y.resize(nb_frames*(nb_frame_bytes+1)*2);
+    for (auto& v: data.x) {
+        v = (uint8_t)byte_dist(rng);
+    }
+
+    int offset = 0;
+    for (int i = 0; i < nb_frames; i++) {
+        enc.reset();
+        for (int j = 0; j < nb_frame_bytes; j++) {
+            offset += enc.consume_byte(data.x[i*nb_frame_bytes + j], &data.y[offset]);
+        }
+        offset += enc.consume_byte(0x00, &data.y[offset]);
+    }
+
+    for (auto& v: data.y) {
+        for (int i = 0; i < 8; i++) {
+            if (error_dist(rng)) {
+                v ^= (uint8_t)(1u << i);
+            }
+        }
+    }
+    return data;
+}
+
+int count_bit_errors(tcb::span<const uint8_t> x0, tcb::span<const uint8_t> x1) {
+    int total = 0;
+    for (size_t i = 0; i < x0.size(); i++) {
+        uint8_t v = x0[i] ^ x1[i];
+        while (v) {
+            total += (v & 0b1);
+            v = v >> 1;
+        }
+    }
+    return total;
+}
+
+// Decoder is a callable which decodes the encoded bytes into the output bytes
+template <typename F>
+Result run_decoder(F&& decode, const TestData& data, const int nb_repeats) {
+    const int nb_bytes = (int)data.x.size();
+    const double nb_bits = (double)nb_bytes * 8.0;
+    std::vector<uint8_t> out(nb_bytes);
+
+    double dt_best = INFINITY;
+    for (int r = 0; r < nb_repeats; r++) {
+        const auto t0 = std::chrono::high_resolution_clock::now();
+        decode(data.y, out);
+        const auto t1 = std::chrono::high_resolution_clock::now();
+        const double dt = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count();
+        dt_best = (dt < dt_best) ? dt : dt_best;
+    }
+
+    Result res;
+    res.mbit_per_second = nb_bits / dt_best * 1e3;
+    res.bit_error_rate = (double)count_bit_errors(data.x, out) / nb_bits;
+    return res;
+}
+
+template <int K, int R>
+Result run_generic(const uint16_t poly[R], const int nb_bytes, const float p_error, const int nb_repeats) {
+    const auto data = create_test_data<K,R>(poly, nb_bytes, p_error);
+    auto vitdec = GenericViterbiDecoder<K,R>(poly, (nb_bytes+1)*8);
+    return run_decoder([&vitdec](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        vitdec.Reset();
+        vitdec.Update(y);
+        vitdec.GetTraceback(x);
+    }, data, nb_repeats);
+}
+
+template <int K, int R>
+Result run_streaming(const uint16_t poly[R], const int nb_bytes, const float p_error, const int nb_repeats) {
+    const auto data = create_test_data<K,R>(poly, nb_bytes, p_error);
+    auto vitdec = StreamingViterbiDecoder<K,R>(poly, 6*K);
+    // decoded output includes the trellis terminator
+    std::vector<uint8_t> out(nb_bytes+1);
+    return run_decoder([&vitdec, &out](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        vitdec.Reset();
+        int nb_out = vitdec.Update(y, out);
+        nb_out += vitdec.Flush({ &out[nb_out], out.size()-nb_out });
+        std::copy_n(out.begin(), x.size(), x.begin());
+    }, data, nb_repeats);
+}
+
+Result run_phil_karn(const uint16_t poly[2], const int nb_bytes, const float p_error, const int nb_repeats) {
+    const auto data = create_test_data<3,2>(poly, nb_bytes, p_error);
+    const uint8_t poly_u8[2] = { (uint8_t)poly[0], (uint8_t)poly[1] };
+    auto vitdec = ViterbiDecoder(poly_u8, (nb_bytes+1)*8);
+    return run_decoder([&vitdec](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        vitdec.Reset();
+        vitdec.Update(y);
+        vitdec.GetTraceback(x);
+    }, data, nb_repeats);
+}
+
+Result run_hard_decision(const uint16_t poly[2], const int nb_bytes, const float p_error, const int nb_repeats) {
+    const auto data = create_test_data<3,2>(poly, nb_bytes, p_error);
+    const uint8_t poly_u8[2] = { (uint8_t)poly[0], (uint8_t)poly[1] };
+    auto vitdec = HardDecisionViterbiDecoder(poly_u8, (nb_bytes+1)*8);
+    return run_decoder([&vitdec](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        vitdec.Reset();
+        vitdec.Update(y);
+        vitdec.GetTraceback(x);
+    }, data, nb_repeats);
+}
+
+struct BatchResult {
+    Result serial;
+    Result batch;
+    int nb_frames;
+    int nb_mismatches;
+};
+
+// The batch decoder should give the same decoded bytes and path error as the single frame decoder
+BatchResult run_batch(const uint16_t poly[2], const int nb_frames, const int nb_frame_bytes, const float p_error, const int nb_repeats) {
+    const auto data = create_frame_test_data(poly, nb_frames, nb_frame_bytes, p_error);
+    const uint8_t poly_u8[2] = { (uint8_t)poly[0], (uint8_t)poly[1] };
+    const int nb_encoded_bytes = (nb_frame_bytes+1)*2;
+    std::vector<int16_t> serial_errors(nb_frames);
+    std::vector<int16_t> batch_errors(nb_frames);
+
+    auto serial_vitdec = ViterbiDecoder(poly_u8, (nb_frame_bytes+1)*8);
+    auto decode_serial = [&](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        for (int i = 0; i < nb_frames; i++) {
+            serial_vitdec.Reset();
+            serial_vitdec.Update(y.subspan(i*nb_encoded_bytes, nb_encoded_bytes));
+            serial_vitdec.GetTraceback(x.subspan(i*nb_frame_bytes, nb_frame_bytes));
+            serial_errors[i] = serial_vitdec.GetPathError();
+        }
+    };
+
+    auto batch_vitdec = BatchViterbiDecoder(poly_u8, nb_frames, nb_encoded_bytes);
+    auto decode_batch = [&](tcb::span<const uint8_t> y, tcb::span<uint8_t> x) {
+        for (int i = 0; i < nb_frames; i++) {
+            batch_vitdec.Submit(y.subspan(i*nb_encoded_bytes, nb_encoded_bytes), i);
+        }
+        batch_vitdec.Process();
+        batch_vitdec.Collect([&](const int i, tcb::span<uint8_t> decoded, const int16_t path_error) {
+            std::copy_n(decoded.begin(), nb_frame_bytes, x.begin() + i*nb_frame_bytes);
+            batch_errors[i] = path_error;
+        });
+    };
+
+    BatchResult res;
+    res.serial = run_decoder(decode_serial, data, nb_repeats);
+    res.batch = run_decoder(decode_batch, data, nb_repeats);
+
+    std::vector<uint8_t> x_serial(data.x.size());
+    std::vector<uint8_t> x_batch(data.x.size());
+    decode_serial(data.y, x_serial);
+    decode_batch(data.y, x_batch);
+    res.nb_frames = nb_frames;
+    res.nb_mismatches = 0;
+    for (int i = 0; i < nb_frames; i++) {
+        const bool is_bytes_equal = memcmp(&x_serial[i*nb_frame_bytes], &x_batch[i*nb_frame_bytes], nb_frame_bytes) == 0;
+        const bool is_error_equal = serial_errors[i] == batch_errors[i];
+        res.nb_mismatches += (is_bytes_equal && is_error_equal) ? 0 : 1;
+    }
+    return res;
+}
+
+int main(int argc, char** argv) {
+    int N = 1 << 20;
+    float p_error = 0.01f;
+    int nb_repeats = 5;
+    int nb_frame_bytes = 32;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "n:p:f:r:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            N = (int)(atof(optarg));
+            if (N <= 0) {
+                fprintf(stderr, "Number of bits must be positive (%d)\n", N);
+                return 1;
+            }
+            break;
+        case 'p':
+            p_error = (float)(atof(optarg));
+            if ((p_error < 0.0f) || (p_error > 1.0f)) {
+                fprintf(stderr, "Bit error probability must be between 0 and 1 (%.3f)\n", p_error);
+                return 1;
+            }
+            break;
+        case 'f':
+            nb_frame_bytes = (int)(atof(optarg));
+            if (nb_frame_bytes <= 0) {
+                fprintf(stderr, "Number of bytes per frame must be positive (%d)\n", nb_frame_bytes);
+                return 1;
+            }
+            break;
+        case 'r':
+            nb_repeats = (int)(atof(optarg));
+            if (nb_repeats <= 0) {
+                fprintf(stderr, "Number of repeats must be positive (%d)\n", nb_repeats);
+                return 1;
+            }
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    const int nb_bytes = (N+7)/8;
+    const int nb_frames = std::max(nb_bytes/nb_frame_bytes, 1);
+    const uint16_t poly_k3[] = { 07, 05 };
+    const uint16_t poly_k5[] = { 023, 035 };
+    const uint16_t poly_k7[] = { 0171, 0133 };
+    const uint16_t poly_k9[] = { 0561, 0753 };
+    const uint16_t poly_k7_r3[] = { 0133, 0171, 0165 };
+
+    fprintf(stdout, "%-24s %12s %12s\n", "decoder", "Mbit/s", "BER");
+    auto print = [](const char* name, const Result& res) {
+        fprintf(stdout, "%-24s %12.2f %12.3e\n", name, res.mbit_per_second, res.bit_error_rate);
+    };
+    print("phil_karn K=3 R=1/2",  run_phil_karn(poly_k3, nb_bytes, p_error, nb_repeats));
+    print("hard_table K=3 R=1/2", run_hard_decision(poly_k3, nb_bytes, p_error, nb_repeats));
+    print("generic K=3 R=1/2",    run_generic<3,2>(poly_k3, nb_bytes, p_error, nb_repeats));
+    print("generic K=5 R=1/2",    run_generic<5,2>(poly_k5, nb_bytes, p_error, nb_repeats));
+    print("generic K=7 R=1/2",    run_generic<7,2>(poly_k7, nb_bytes, p_error, nb_repeats));
+    print("generic K=9 R=1/2",    run_generic<9,2>(poly_k9, nb_bytes, p_error, nb_repeats));
+    print("generic K=7 R=1/3",    run_generic<7,3>(poly_k7_r3, nb_bytes, p_error, nb_repeats));
+    print("streaming K=3 R=1/2",  run_streaming<3,2>(poly_k3, nb_bytes, p_error, nb_repeats));
+    print("streaming K=7 R=1/2",  run_streaming<7,2>(poly_k7, nb_bytes, p_error, nb_repeats));
+
+    const auto batch = run_batch(poly_k3, nb_frames, nb_frame_bytes, p_error, nb_repeats);
+    print("phil_karn frames K=3",  batch.serial);
+    print("batch frames K=3",      batch.batch);
+    fprintf(stdout, "batch mismatches: %d/%d frames\n", batch.nb_mismatches, batch.nb_frames);
+
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "constellation.h"
+#include <assert.h>
+#include "dsp/simd/c32_square_demap.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -11,8 +13,16 @@ SquareConstellation::SquareConstellation(const int _L)
     phase_lookup.resize(N);
     gray_code.resize(N);
 
-    const float offset = (L-1)/2.0f;
+    offset = (L-1)/2.0f;
     const float scale = 1.0f/std::sqrt(2.0f) * 1.0f/offset * 0.5f;
+    // distance between adjacent symbols along an axis
+    step = 2.0f*scale;
+    inv_step = 1.0f/step;
+
+    bits_per_axis = 0;
+    while ((1 << bits_per_axis) < L) {
+        bits_per_axis++;
+    }
 
     for (int i = 0; i < L; i++) {
         const float I = 2.0f * ((float)i - offset);
@@ -29,16 +39,14 @@ SquareConstellation::SquareConstellation(const int _L)
         phase_lookup[i] = std::atan2(c.real(), c.imag());
     }
 
-    // generate gray code
-    // TODO: generalise this?
-    uint8_t _gray_code[4] = {0b00, 0b01, 0b11, 0b10};
-    for (uint8_t i = 0; i < L; i++) {
-        for (uint8_t q = 0; q < L; q++) {
-            uint8_t I = _gray_code[i];
-            uint8_t Q = _gray_code[q];
-            uint8_t idx = (i<<2) | q;
-            uint8_t sym = (I<<2) | Q;
-            gray_code[idx] = sym;
+    // generate gray code for each axis
+    for (int i = 0; i < L; i++) {
+        for (int q = 0; q < L; q++) {
+            const int I = i ^ (i >> 1);
+            const int Q = q ^ (q >> 1);
+            const int idx = i*L + q;
+            const int sym = (I << bits_per_axis) | Q;
+            gray_code[idx] = (uint8_t)sym;
         }
     }
 
@@ -48,19 +56,62 @@ SquareConstellation::SquareConstellation(const int _L)
 SquareConstellation::~SquareConstellation() = default;
 
 uint8_t SquareConstellation::GetNearestSymbol(const std::complex<float> x) {
-    float min_err = INFINITY;
-    uint8_t best_match = 0;
-
-    for (uint8_t i = 0; i < N; i++) {
-        auto err_vec = constellation[i]-x;
-        auto err = std::abs(err_vec);
-        if (err < min_err) {
-            best_match = i;
-            min_err = err;
-        }
+    return gray_code[SliceAxis(x.real())*L + SliceAxis(x.imag())];
+}
+
+ConstellationSlice SquareConstellation::Slice(const std::complex<float> x) {
+    const int idx = SliceAxis(x.real())*L + SliceAxis(x.imag());
+    return {idx, gray_code[idx], x-constellation[idx]};
+}
+
+// get the index of the nearest symbol along a single axis
+int SquareConstellation::SliceAxis(const float x) const {
+    float i = x*inv_step + offset;
+    i = (i < 0.0f) ? 0.0f : i;
+    i = (i > (float)(L-1)) ? (float)(L-1) : i;
+    return (int)(i + 0.5f);
+}
+
+void SquareConstellation::DemapSymbols(
+    tcb::span<const std::complex<float>> x, tcb::span<uint8_t> bits,
+    tcb::span<float> mag_error, tcb::span<float> phase_error)
+{
+    const int N = (int)x.size();
+    const int nb_bits = GetBitsPerSymbol();
+    assert(bits.size() >= (size_t)((N*nb_bits + 7)/8));
+    assert(mag_error.empty() || (mag_error.size() >= x.size()));
+    assert(phase_error.empty() || (phase_error.size() >= x.size()));
+
+    const auto params = GetDemapParams();
+
+    // demap in chunks so the unpacked symbols stay on the stack
+    constexpr int CHUNK_SIZE = 256;
+    uint8_t symbols[CHUNK_SIZE];
+    int wr_bit = 0;
+    for (int i = 0; i < N; i += CHUNK_SIZE) {
+        const int M = ((N-i) < CHUNK_SIZE) ? (N-i) : CHUNK_SIZE;
+        c32_square_demap_auto(
+            &x[i], symbols, 
+            mag_error.empty() ? NULL : &mag_error[i],
+            phase_error.empty() ? NULL : &phase_error[i],
+            M, params);
+        wr_bit = PackSymbols({ symbols, (size_t)M }, nb_bits, bits, wr_bit);
     }
+}
+
+void SquareConstellation::SliceSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> symbols) {
+    assert(symbols.size() >= x.size());
+    const auto params = GetDemapParams();
+    c32_square_demap_auto(x.data(), symbols.data(), NULL, NULL, (int)x.size(), params);
+}
 
-    return gray_code[best_match];
+SquareDemapParams SquareConstellation::GetDemapParams() const {
+    SquareDemapParams params;
+    params.L = L;
+    params.bits_per_axis = bits_per_axis;
+    params.offset = offset;
+    params.step = step;
+    return params;
 }
 
 float SquareConstellation::CalculateAveragePower(const std::complex<float>* C, const int N) {
@@ -75,15 +126,11 @@ float SquareConstellation::CalculateAveragePower(const std::complex<float>* C, c
     return avg_power;
 }
 
-static float* phase_cache = NULL;
-
-// get the phase error from the known constellation
-ConstellationErrorResult estimate_phase_error(const std::complex<float> x, ConstellationSpecification& s) {
+ConstellationSlice ConstellationSpecification::Slice(const std::complex<float> x) {
     int min_index = 0;
     float best_mag_error = INFINITY;
-    const int N = s.GetSize();
-    const auto* constellation = s.GetSymbols();
-    const auto* phases = s.GetPhaseLookup();
+    const int N = GetSize();
+    const auto* constellation = GetSymbols();
 
     for (int i = 0; i < N; i++) {
         auto error = x - constellation[i];
@@ -97,16 +144,77 @@ ConstellationErrorResult estimate_phase_error(const std::complex<float> x, Const
         }
     }
 
-    const auto closest_point = constellation[min_index];
+    return {min_index, GetNearestSymbol(x), x-constellation[min_index]};
+}
+
+void ConstellationSpecification::DemapSymbols(
+    tcb::span<const std::complex<float>> x, tcb::span<uint8_t> bits,
+    tcb::span<float> mag_error, tcb::span<float> phase_error)
+{
+    const int N = (int)x.size();
+    const int nb_bits = GetBitsPerSymbol();
+    const auto* constellation = GetSymbols();
+    assert(bits.size() >= (size_t)((N*nb_bits + 7)/8));
+
+    int wr_bit = 0;
+    for (int i = 0; i < N; i++) {
+        const auto res = Slice(x[i]);
+        if (!mag_error.empty()) {
+            mag_error[i] = std::abs(res.error);
+        }
+        if (!phase_error.empty()) {
+            phase_error[i] = std::arg(x[i]*std::conj(constellation[res.index]));
+        }
+        wr_bit = PackSymbols({ &res.symbol, 1 }, nb_bits, bits, wr_bit);
+    }
+}
+
+void ConstellationSpecification::SliceSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> symbols) {
+    assert(symbols.size() >= x.size());
+    const int N = (int)x.size();
+    for (int i = 0; i < N; i++) {
+        symbols[i] = Slice(x[i]).symbol;
+    }
+}
+
+int ConstellationSpecification::PackSymbols(
+    tcb::span<const uint8_t> symbols, const int nb_bits, 
+    tcb::span<uint8_t> bits, int wr_bit) 
+{
+    // accumulate symbols and flush whole bytes
+    int byte = wr_bit / 8;
+    int nb_acc = wr_bit % 8;
+    uint32_t acc = (nb_acc > 0) ? (bits[byte] >> (8-nb_acc)) : 0;
+    for (auto sym: symbols) {
+        acc = (acc << nb_bits) | sym;
+        nb_acc += nb_bits;
+        while (nb_acc >= 8) {
+            nb_acc -= 8;
+            bits[byte++] = (uint8_t)(acc >> nb_acc);
+        }
+        acc &= (1u << nb_acc) - 1u;
+    }
+
+    if (nb_acc > 0) {
+        bits[byte] = (uint8_t)(acc << (8-nb_acc));
+    }
+    return byte*8 + nb_acc;
+}
+
+// get the phase error from the known constellation
+ConstellationErrorResult estimate_phase_error(const std::complex<float> x, ConstellationSpecification& s) {
+    const auto* phases = s.GetPhaseLookup();
+    const auto res = s.Slice(x);
+
     // const float angle1 = std::atan2f(closest_point.real(), closest_point.imag());
-    const float angle1 = phases[min_index];
+    const float angle1 = phases[res.index];
     const float angle2 = std::atan2(x.real(), x.imag());
 
     float phase_error = angle1-angle2;
     phase_error = std::fmod(phase_error + 3*PI, 2*PI);
     phase_error -= PI;
 
-    best_mag_error = std::sqrt(best_mag_error);
+    const float mag_error = std::abs(res.error);
 
-    return {phase_error, best_mag_error};
+    return {phase_error, mag_error};
 }
\ No newline at end of file
@@ -3,6 +3,17 @@
 #include <complex>
 #include <vector>
 #include <stdint.h>
+#include "utility/span.h"
+
+struct SquareDemapParams;
+
+// result of slicing a received symbol onto the constellation
+struct ConstellationSlice 
+{
+    int index;                  // index into the constellation symbols
+    uint8_t symbol;             // gray coded bits of the symbol
+    std::complex<float> error;  // received minus the reference symbol
+};
 
 class ConstellationSpecification {
 public:
@@ -15,28 +26,61 @@ public:
     virtual int GetBitsPerSymbol() = 0;
     virtual uint8_t GetNearestSymbol(const std::complex<float> x) = 0;
     virtual float GetAveragePower() = 0; 
+    // NOTE: Default implementation searches every symbol for the nearest match
+    //       Constellations with a regular layout should override this with a direct decision
+    virtual ConstellationSlice Slice(const std::complex<float> x);
+    // Demap a block of symbols in one pass
+    // x = received symbols
+    // bits = hard decisions packed msb first with GetBitsPerSymbol() bits per symbol
+    // mag_error = distance to the nearest symbol (optional, empty to skip)
+    // phase_error = arg(x*conj(nearest symbol)) (optional, empty to skip)
+    virtual void DemapSymbols(
+        tcb::span<const std::complex<float>> x, tcb::span<uint8_t> bits,
+        tcb::span<float> mag_error, tcb::span<float> phase_error);
+    // Slice a block of symbols without packing them
+    // symbols = gray coded bits of the nearest symbol, one per byte
+    virtual void SliceSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> symbols);
+protected:
+    // Pack symbols msb first into a bit stream starting at wr_bit
+    // return the bit position after the last symbol
+    static int PackSymbols(
+        tcb::span<const uint8_t> symbols, const int nb_bits, 
+        tcb::span<uint8_t> bits, int wr_bit);
 };
 
 class SquareConstellation: public ConstellationSpecification {
 private:
     const int L;
     const int N;
+    int bits_per_axis;
+    float offset;
+    float step;
+    float inv_step;
     std::vector<std::complex<float>> constellation;
     std::vector<float> phase_lookup;
     std::vector<uint8_t> gray_code;
     float m_avg_power;
 public:
-    // L = number of symbols along one axis
+    // L = number of symbols along one axis, must be a power of 2
     // Constellation is spaced 2 units apart, center at (0,0)
     SquareConstellation(const int _L);
     virtual ~SquareConstellation();
     virtual std::complex<float>* GetSymbols() { return constellation.data(); }
     virtual float* GetPhaseLookup() { return phase_lookup.data(); }
     virtual int GetSize() { return N; };
-    virtual int GetBitsPerSymbol() { return L; };
+    virtual int GetBitsPerSymbol() { return 2*bits_per_axis; };
     virtual float GetAveragePower() { return m_avg_power; }; 
     virtual uint8_t GetNearestSymbol(const std::complex<float> x);
+    // Decision is made by quantising I and Q independently
+    // This is O(1) regardless of the constellation size
+    virtual ConstellationSlice Slice(const std::complex<float> x);
+    virtual void DemapSymbols(
+        tcb::span<const std::complex<float>> x, tcb::span<uint8_t> bits,
+        tcb::span<float> mag_error, tcb::span<float> phase_error);
+    virtual void SliceSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> symbols);
 private:
+    SquareDemapParams GetDemapParams() const;
+    int SliceAxis(const float x) const;
     float CalculateAveragePower(const std::complex<float>* C, const int N);
 };
 
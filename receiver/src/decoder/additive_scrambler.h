@@ -1,6 +1,10 @@
 #pragma once
 
+#include <assert.h>
 #include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "dsp/simd/u8_xor.h"
 
 // https://en.wikipedia.org/wiki/Scrambler
 // XOR's a source byte with an internal register
@@ -31,3 +35,32 @@ public:
         return x ^ mask;
     }
 };
+
+// The scrambler is reset to the same syncword at the start of every frame
+// This means every frame is xored with the same sequence of bytes
+// We precompute this keystream once so scrambling a frame is a vectorised xor
+class AdditiveScramblerKeystream {
+private:
+    std::vector<uint8_t> keystream;
+public:
+    // max_length = longest frame in bytes that can be scrambled
+    AdditiveScramblerKeystream(const uint16_t syncword, const int max_length) {
+        auto scrambler = AdditiveScrambler(syncword);
+        keystream.resize(max_length);
+        for (auto& v: keystream) {
+            v = scrambler.process(0x00);
+        }
+    }
+    // y[i] = x[i] ^ keystream[offset+i]
+    // offset = position of x from the start of the frame
+    // NOTE: y can be the same as x
+    void process(tcb::span<const uint8_t> x, tcb::span<uint8_t> y, const int offset) {
+        assert(x.size() <= y.size());
+        assert((offset + x.size()) <= keystream.size());
+        u8_xor_auto(x.data(), &keystream[offset], y.data(), (int)x.size());
+    }
+    uint8_t process(const uint8_t x, const int offset) {
+        return x ^ keystream[offset];
+    }
+    int GetMaxLength() const { return (int)keystream.size(); }
+};
\ No newline at end of file
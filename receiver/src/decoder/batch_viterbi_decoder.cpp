@@ -0,0 +1,451 @@
+#include "batch_viterbi_decoder.h"
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "dsp/simd/simd_config.h"
+#include "dsp/simd/cpu_features.h"
+
+// Same initial metrics and renormalisation as phil_karn_viterbi_decoder.h
+// This keeps the path error identical to the single frame decoder
+constexpr int16_t RENORMALIZE_THRESHOLD = SHRT_MAX-3000;
+constexpr int16_t INITIAL_START_ERROR = 0;
+constexpr int16_t INITIAL_NON_START_ERROR = 0+3000;
+
+static uint8_t get_parity(uint32_t x) {
+    uint8_t parity = 0;
+    while (x) {
+        parity ^= (x & 0b1);
+        x = x >> 1;
+    }
+    return parity;
+}
+
+// The lane kernels are compiled for each instruction set and selected like the dsp/simd kernels
+// Unused lanes have zero steps and no buffers
+constexpr int TOTAL_LANES = BatchViterbiDecoder::TOTAL_LANES;
+constexpr int TOTAL_STATES = BatchViterbiDecoder::TOTAL_STATES;
+constexpr int CONSTRAINT_LENGTH_K = BatchViterbiDecoder::CONSTRAINT_LENGTH_K;
+
+static inline
+void interleave_lanes_scalar(
+    const uint8_t* const* lane_encoded, const int* lane_nb_bytes, const int nb_lanes, const int nb_bytes,
+    int16_t* soft_bits)
+{
+    // Lanes which finish early or are unused are padded as punctured bits
+    for (int i = 0; i < nb_bytes*8*TOTAL_LANES; i++) {
+        soft_bits[i] = SOFT_DECISION_VITERBI_PUNCTURED;
+    }
+    for (int lane = 0; lane < nb_lanes; lane++) {
+        const uint8_t* encoded = lane_encoded[lane];
+        const int N = lane_nb_bytes[lane];
+        for (int i = 0; i < N; i++) {
+            const uint8_t b = encoded[i];
+            for (int j = 0; j < 8; j++) {
+                const bool v = (b & (1 << (7-j))) != 0;
+                soft_bits[(i*8 + j)*TOTAL_LANES + lane] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+            }
+        }
+    }
+}
+
+static inline
+void update_lanes_scalar(
+    const int16_t* soft_bits, int16_t* decisions, const int16_t* branch_table, const int16_t max_error,
+    const int nb_steps, const int* lane_steps, int16_t* path_errors)
+{
+    int16_t metrics[TOTAL_STATES][TOTAL_LANES];
+    int16_t new_metrics[TOTAL_STATES][TOTAL_LANES];
+    for (int i = 0; i < TOTAL_STATES; i++) {
+        for (int lane = 0; lane < TOTAL_LANES; lane++) {
+            metrics[i][lane] = (i == 0) ? INITIAL_START_ERROR : INITIAL_NON_START_ERROR;
+        }
+    }
+
+    for (int s = 0; s < nb_steps; s++) {
+        int16_t* d = &decisions[s*TOTAL_STATES*TOTAL_LANES];
+        for (int lane = 0; lane < TOTAL_LANES; lane++) {
+            for (int i = 0; i < TOTAL_STATES/2; i++) {
+                int16_t metric = 0;
+                for (int j = 0; j < CODE_RATE; j++) {
+                    int16_t error = branch_table[j*TOTAL_STATES/2 + i] - soft_bits[(s*CODE_RATE + j)*TOTAL_LANES + lane];
+                    metric += (error > 0) ? error : -error;
+                }
+                const int16_t metric_inv = max_error - metric;
+
+                const int16_t m0 = metrics[i][lane] + metric;
+                const int16_t m1 = metrics[i+TOTAL_STATES/2][lane] + metric_inv;
+                const int16_t m2 = metrics[i][lane] + metric_inv;
+                const int16_t m3 = metrics[i+TOTAL_STATES/2][lane] + metric;
+
+                const bool decision0 = (m0 > m1);
+                const bool decision1 = (m2 > m3);
+                new_metrics[2*i][lane]   = decision0 ? m1 : m0;
+                new_metrics[2*i+1][lane] = decision1 ? m3 : m2;
+                d[(2*i)*TOTAL_LANES + lane]   = decision0 ? -1 : 0;
+                d[(2*i+1)*TOTAL_LANES + lane] = decision1 ? -1 : 0;
+            }
+
+            int16_t min_metric = new_metrics[0][lane];
+            for (int i = 1; i < TOTAL_STATES; i++) {
+                min_metric = (new_metrics[i][lane] < min_metric) ? new_metrics[i][lane] : min_metric;
+            }
+            const int16_t offset = (new_metrics[0][lane] > RENORMALIZE_THRESHOLD) ? min_metric : 0;
+            for (int i = 0; i < TOTAL_STATES; i++) {
+                metrics[i][lane] = new_metrics[i][lane] - offset;
+            }
+
+            if (lane_steps[lane] == (s+1)) {
+                path_errors[lane] = metrics[0][lane];
+            }
+        }
+    }
+}
+
+static inline
+void chainback_lanes_scalar(
+    const int16_t* decisions, uint8_t* const* lane_decoded, const int nb_lanes, const int* lane_steps)
+{
+    constexpr int K = CONSTRAINT_LENGTH_K;
+
+    for (int lane = 0; lane < nb_lanes; lane++) {
+        const int nb_bits = lane_steps[lane];
+        uint8_t* data = lane_decoded[lane];
+        for (int i = 0; i < nb_bits/8; i++) {
+            data[i] = 0x00;
+        }
+
+        // Frames end in the zero state due to the trellis null terminator
+        // ignore the tail bits by starting K-1 decisions in
+        // NOTE: Decisions past the end of the frame are treated as zero like the single frame decoder
+        int curr_state = 0;
+        for (int i = nb_bits-1; i >= 0; i--) {
+            const int step = i + (K-1);
+            uint8_t input = 0;
+            if (step < nb_bits) {
+                input = decisions[(step*TOTAL_STATES + curr_state)*TOTAL_LANES + lane] & 0b1;
+            }
+            curr_state = (curr_state >> 1) | (input << (K-2));
+            data[i/8] |= (input << (7-(i % 8)));
+        }
+    }
+}
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline
+void interleave_lanes_avx2(
+    const uint8_t* const* lane_encoded, const int* lane_nb_bytes, const int nb_lanes, const int nb_bytes,
+    int16_t* soft_bits)
+{
+    // Lanes which finish early or are unused are padded as punctured bits
+    const __m256i soft_high = _mm256_set1_epi16(SOFT_DECISION_VITERBI_HIGH);
+    const __m256i soft_low = _mm256_set1_epi16(SOFT_DECISION_VITERBI_LOW);
+    alignas(16) uint8_t lane_bytes[TOTAL_LANES];
+    alignas(16) int8_t lane_valid[TOTAL_LANES];
+
+    for (int i = 0; i < nb_bytes; i++) {
+        for (int lane = 0; lane < TOTAL_LANES; lane++) {
+            const bool is_valid = (lane < nb_lanes) && (i < lane_nb_bytes[lane]);
+            lane_bytes[lane] = is_valid ? lane_encoded[lane][i] : 0;
+            lane_valid[lane] = is_valid ? -1 : 0;
+        }
+        const __m256i bytes = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(lane_bytes)));
+        const __m256i valid = _mm256_cvtepi8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(lane_valid)));
+        for (int j = 0; j < 8; j++) {
+            const __m256i bit_mask = _mm256_set1_epi16(1 << (7-j));
+            const __m256i is_high = _mm256_cmpeq_epi16(_mm256_and_si256(bytes, bit_mask), bit_mask);
+            const __m256i soft_bit = _mm256_and_si256(_mm256_blendv_epi8(soft_low, soft_high, is_high), valid);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&soft_bits[(i*8 + j)*TOTAL_LANES]), soft_bit);
+        }
+    }
+}
+
+static inline
+void update_lanes_avx2(
+    const int16_t* soft_bits, int16_t* decisions, const int16_t* branch_table, const int16_t max_error,
+    const int nb_steps, const int* lane_steps, int16_t* path_errors)
+{
+    __m256i metrics[TOTAL_STATES];
+    __m256i new_metrics[TOTAL_STATES];
+    for (int i = 0; i < TOTAL_STATES; i++) {
+        metrics[i] = _mm256_set1_epi16(INITIAL_NON_START_ERROR);
+    }
+    metrics[0] = _mm256_set1_epi16(INITIAL_START_ERROR);
+
+    const __m256i v_max_error = _mm256_set1_epi16(max_error);
+    const __m256i threshold = _mm256_set1_epi16(RENORMALIZE_THRESHOLD);
+    __m256i branch[CODE_RATE*TOTAL_STATES/2];
+    for (int i = 0; i < CODE_RATE*TOTAL_STATES/2; i++) {
+        branch[i] = _mm256_set1_epi16(branch_table[i]);
+    }
+
+    // Next step where a lane finishes and we need to read its path error
+    int next_lane_step = nb_steps;
+    for (int lane = 0; lane < TOTAL_LANES; lane++) {
+        if ((lane_steps[lane] > 0) && (lane_steps[lane] < next_lane_step)) {
+            next_lane_step = lane_steps[lane];
+        }
+    }
+
+    for (int s = 0; s < nb_steps; s++) {
+        __m256i syms[CODE_RATE];
+        for (int j = 0; j < CODE_RATE; j++) {
+            syms[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&soft_bits[(s*CODE_RATE + j)*TOTAL_LANES]));
+        }
+
+        __m256i* d = reinterpret_cast<__m256i*>(&decisions[s*TOTAL_STATES*TOTAL_LANES]);
+        for (int i = 0; i < TOTAL_STATES/2; i++) {
+            // Absolute difference between expected and received soft decision bits
+            __m256i metric = _mm256_setzero_si256();
+            for (int j = 0; j < CODE_RATE; j++) {
+                metric = _mm256_add_epi16(metric, _mm256_abs_epi16(_mm256_sub_epi16(branch[j*TOTAL_STATES/2 + i], syms[j])));
+            }
+            const __m256i metric_inv = _mm256_sub_epi16(v_max_error, metric);
+
+            const __m256i m0 = _mm256_add_epi16(metrics[i], metric);
+            const __m256i m1 = _mm256_add_epi16(metrics[i+TOTAL_STATES/2], metric_inv);
+            const __m256i m2 = _mm256_add_epi16(metrics[i], metric_inv);
+            const __m256i m3 = _mm256_add_epi16(metrics[i+TOTAL_STATES/2], metric);
+
+            const __m256i decision0 = _mm256_cmpgt_epi16(m0, m1);
+            const __m256i decision1 = _mm256_cmpgt_epi16(m2, m3);
+            new_metrics[2*i]   = _mm256_min_epi16(m0, m1);
+            new_metrics[2*i+1] = _mm256_min_epi16(m2, m3);
+            _mm256_store_si256(&d[2*i],   decision0);
+            _mm256_store_si256(&d[2*i+1], decision1);
+        }
+
+        // Renormalise each lane independently if its metric is about to overflow
+        __m256i min_metric = new_metrics[0];
+        for (int i = 1; i < TOTAL_STATES; i++) {
+            min_metric = _mm256_min_epi16(min_metric, new_metrics[i]);
+        }
+        const __m256i is_renormalise = _mm256_cmpgt_epi16(new_metrics[0], threshold);
+        const __m256i offset = _mm256_and_si256(min_metric, is_renormalise);
+        for (int i = 0; i < TOTAL_STATES; i++) {
+            metrics[i] = _mm256_sub_epi16(new_metrics[i], offset);
+        }
+
+        if ((s+1) == next_lane_step) {
+            alignas(32) int16_t state0_metrics[TOTAL_LANES];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(state0_metrics), metrics[0]);
+            next_lane_step = nb_steps;
+            for (int lane = 0; lane < TOTAL_LANES; lane++) {
+                if (lane_steps[lane] == (s+1)) {
+                    path_errors[lane] = state0_metrics[lane];
+                } else if ((lane_steps[lane] > (s+1)) && (lane_steps[lane] < next_lane_step)) {
+                    next_lane_step = lane_steps[lane];
+                }
+            }
+        }
+    }
+}
+
+static inline
+void chainback_lanes_avx2(
+    const int16_t* decisions, uint8_t* const* lane_decoded, const int nb_lanes, const int* lane_steps)
+{
+    constexpr int K = CONSTRAINT_LENGTH_K;
+    // all lanes are traced back together from the end of the longest frame
+    int nb_steps = 0;
+    alignas(32) int16_t lane_steps_16[TOTAL_LANES];
+    for (int lane = 0; lane < TOTAL_LANES; lane++) {
+        lane_steps_16[lane] = (int16_t)lane_steps[lane];
+        nb_steps = (lane_steps[lane] > nb_steps) ? lane_steps[lane] : nb_steps;
+    }
+    const __m256i v_lane_steps = _mm256_load_si256(reinterpret_cast<const __m256i*>(lane_steps_16));
+    const __m256i one = _mm256_set1_epi16(1);
+
+    // Trace back all lanes together, each frame ends in the zero state due to the trellis null terminator
+    // ignore the tail bits by starting K-1 decisions in
+    // NOTE: Decisions past the end of a frame are treated as zero like the single frame decoder
+    __m256i curr_state = _mm256_setzero_si256();
+    __m256i data = _mm256_setzero_si256();
+    alignas(32) int16_t lane_data[TOTAL_LANES];
+
+    for (int i = nb_steps-1; i >= 0; i--) {
+        const int step = i + (K-1);
+        __m256i input = _mm256_setzero_si256();
+        if (step < nb_steps) {
+            const __m256i* d = reinterpret_cast<const __m256i*>(&decisions[step*TOTAL_STATES*TOTAL_LANES]);
+            for (int state = 0; state < TOTAL_STATES; state++) {
+                const __m256i is_state = _mm256_cmpeq_epi16(curr_state, _mm256_set1_epi16((int16_t)state));
+                input = _mm256_or_si256(input, _mm256_and_si256(is_state, _mm256_load_si256(&d[state])));
+            }
+            const __m256i is_valid = _mm256_cmpgt_epi16(v_lane_steps, _mm256_set1_epi16((int16_t)step));
+            input = _mm256_and_si256(_mm256_and_si256(input, is_valid), one);
+        }
+        curr_state = _mm256_or_si256(_mm256_srli_epi16(curr_state, 1), _mm256_slli_epi16(input, K-2));
+        data = _mm256_or_si256(data, _mm256_sll_epi16(input, _mm_cvtsi32_si128(7-(i % 8))));
+
+        // Scatter the completed byte of each lane
+        if ((i % 8) == 0) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lane_data), data);
+            for (int lane = 0; lane < nb_lanes; lane++) {
+                if (i < lane_steps[lane]) {
+                    lane_decoded[lane][i/8] = (uint8_t)lane_data[lane];
+                }
+            }
+            data = _mm256_setzero_si256();
+        }
+    }
+}
+DSP_TARGET_END
+#endif
+
+static void interleave_lanes_auto(
+    const uint8_t* const* lane_encoded, const int* lane_nb_bytes, const int nb_lanes, const int nb_bytes,
+    int16_t* soft_bits)
+{
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &interleave_lanes_scalar, &interleave_lanes_scalar, &interleave_lanes_avx2);
+    func(lane_encoded, lane_nb_bytes, nb_lanes, nb_bytes, soft_bits);
+    #elif defined(_DSP_AVX2)
+    interleave_lanes_avx2(lane_encoded, lane_nb_bytes, nb_lanes, nb_bytes, soft_bits);
+    #else
+    interleave_lanes_scalar(lane_encoded, lane_nb_bytes, nb_lanes, nb_bytes, soft_bits);
+    #endif
+}
+
+static void update_lanes_auto(
+    const int16_t* soft_bits, int16_t* decisions, const int16_t* branch_table, const int16_t max_error,
+    const int nb_steps, const int* lane_steps, int16_t* path_errors)
+{
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &update_lanes_scalar, &update_lanes_scalar, &update_lanes_avx2);
+    func(soft_bits, decisions, branch_table, max_error, nb_steps, lane_steps, path_errors);
+    #elif defined(_DSP_AVX2)
+    update_lanes_avx2(soft_bits, decisions, branch_table, max_error, nb_steps, lane_steps, path_errors);
+    #else
+    update_lanes_scalar(soft_bits, decisions, branch_table, max_error, nb_steps, lane_steps, path_errors);
+    #endif
+}
+
+static void chainback_lanes_auto(
+    const int16_t* decisions, uint8_t* const* lane_decoded, const int nb_lanes, const int* lane_steps)
+{
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &chainback_lanes_scalar, &chainback_lanes_scalar, &chainback_lanes_avx2);
+    func(decisions, lane_decoded, nb_lanes, lane_steps);
+    #elif defined(_DSP_AVX2)
+    chainback_lanes_avx2(decisions, lane_decoded, nb_lanes, lane_steps);
+    #else
+    chainback_lanes_scalar(decisions, lane_decoded, nb_lanes, lane_steps);
+    #endif
+}
+
+BatchViterbiDecoder::BatchViterbiDecoder(const uint8_t poly[CODE_RATE], const int max_frames, const int _max_encoded_bytes)
+: max_encoded_bytes(_max_encoded_bytes),
+  max_steps(_max_encoded_bytes*8/CODE_RATE),
+  frames(max_frames),
+  soft_bits(_max_encoded_bytes*8*TOTAL_LANES),
+  decisions(_max_encoded_bytes*8/CODE_RATE*TOTAL_STATES*TOTAL_LANES)
+{
+    for (int state = 0; state < TOTAL_STATES/2; state++) {
+        for (int i = 0; i < CODE_RATE; i++) {
+            const uint8_t v = get_parity((state << 1) & poly[i]);
+            branch_table[i*TOTAL_STATES/2 + state] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+    }
+    soft_decision_max_error = SOFT_DECISION_VITERBI_HIGH - SOFT_DECISION_VITERBI_LOW;
+
+    for (auto& frame: frames) {
+        frame.encoded_bytes.resize(max_encoded_bytes);
+        frame.decoded_bytes.resize(max_encoded_bytes/CODE_RATE);
+    }
+}
+
+bool BatchViterbiDecoder::Submit(tcb::span<const uint8_t> encoded_bytes, const int tag) {
+    if (queue_length == (int)frames.size()) {
+        return false;
+    }
+
+    const int N = (int)encoded_bytes.size();
+    assert(N <= max_encoded_bytes);
+
+    auto& frame = frames[(queue_head+queue_length) % frames.size()];
+    memcpy(frame.encoded_bytes.data(), encoded_bytes.data(), N);
+    frame.nb_encoded_bytes = N;
+    frame.path_error = 0;
+    frame.tag = tag;
+    frame.is_decoded = false;
+    queue_length++;
+    return true;
+}
+
+void BatchViterbiDecoder::Process() {
+    Frame* lanes[TOTAL_LANES];
+    int nb_lanes = 0;
+    for (int i = 0; i < queue_length; i++) {
+        auto& frame = frames[(queue_head+i) % frames.size()];
+        if (frame.is_decoded) {
+            continue;
+        }
+        lanes[nb_lanes++] = &frame;
+        if (nb_lanes == TOTAL_LANES) {
+            DecodeLanes(lanes, nb_lanes);
+            nb_lanes = 0;
+        }
+    }
+
+    if (nb_lanes > 0) {
+        DecodeLanes(lanes, nb_lanes);
+    }
+}
+
+void BatchViterbiDecoder::Collect(const Callback& callback) {
+    while (queue_length > 0) {
+        auto& frame = frames[queue_head];
+        if (!frame.is_decoded) {
+            break;
+        }
+        const int nb_decoded_bytes = frame.nb_encoded_bytes/CODE_RATE;
+        callback(frame.tag, { frame.decoded_bytes.data(), (size_t)nb_decoded_bytes }, frame.path_error);
+        frame.is_decoded = false;
+        queue_head = (queue_head+1) % (int)frames.size();
+        queue_length--;
+    }
+}
+
+int BatchViterbiDecoder::GetTotalPending() const {
+    int total = 0;
+    for (int i = 0; i < queue_length; i++) {
+        const auto& frame = frames[(queue_head+i) % frames.size()];
+        total += frame.is_decoded ? 0 : 1;
+    }
+    return total;
+}
+
+void BatchViterbiDecoder::DecodeLanes(Frame** lanes, const int nb_lanes) {
+    const uint8_t* lane_encoded[TOTAL_LANES] = {NULL};
+    uint8_t* lane_decoded[TOTAL_LANES] = {NULL};
+    int lane_nb_bytes[TOTAL_LANES] = {0};
+    int lane_steps[TOTAL_LANES] = {0};
+    int nb_steps = 0;
+    for (int i = 0; i < nb_lanes; i++) {
+        lane_encoded[i] = lanes[i]->encoded_bytes.data();
+        lane_decoded[i] = lanes[i]->decoded_bytes.data();
+        lane_nb_bytes[i] = lanes[i]->nb_encoded_bytes;
+        lane_steps[i] = lanes[i]->nb_encoded_bytes*8/CODE_RATE;
+        nb_steps = (lane_steps[i] > nb_steps) ? lane_steps[i] : nb_steps;
+    }
+
+    interleave_lanes_auto(lane_encoded, lane_nb_bytes, nb_lanes, nb_steps*CODE_RATE/8, soft_bits.data());
+
+    int16_t path_errors[TOTAL_LANES] = {0};
+    update_lanes_auto(
+        soft_bits.data(), decisions.data(), branch_table, (int16_t)(CODE_RATE*soft_decision_max_error),
+        nb_steps, lane_steps, path_errors);
+    chainback_lanes_auto(decisions.data(), lane_decoded, nb_lanes, lane_steps);
+
+    for (int lane = 0; lane < nb_lanes; lane++) {
+        lanes[lane]->path_error = path_errors[lane];
+        lanes[lane]->is_decoded = true;
+    }
+}
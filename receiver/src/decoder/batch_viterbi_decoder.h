@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "utility/span.h"
+#include "utility/aligned_vector.h"
+#include "viterbi_config.h"
+
+#define CODE_RATE 2
+
+// Decodes many independent frames at once by placing each frame's trellis in a separate SIMD lane
+// With K=3 there are only 4 states which is too few to fill a vector for a single frame
+// Frames are queued with Submit(), decoded together with Process() and returned with Collect()
+// NOTE: Each frame is decoded from the zero state and chained back into the zero state
+//       This gives the same decoded bits and path error as ViterbiDecoder over the whole frame
+class BatchViterbiDecoder
+{
+public:
+    // AVX2 holds 16 int16_t metrics per register
+    static constexpr int TOTAL_LANES = 16;
+    static constexpr int CONSTRAINT_LENGTH_K = 3;
+    static constexpr int TOTAL_STATES = 1 << (CONSTRAINT_LENGTH_K-1);
+    using Callback = std::function<void(const int tag, tcb::span<uint8_t> decoded_bytes, const int16_t path_error)>;
+private:
+    struct Frame {
+        std::vector<uint8_t> encoded_bytes;
+        std::vector<uint8_t> decoded_bytes;
+        int nb_encoded_bytes = 0;
+        int16_t path_error = 0;
+        int tag = 0;
+        bool is_decoded = false;
+    };
+    const int max_encoded_bytes;
+    const int max_steps;
+    // branch_table[i*TOTAL_STATES/2 + state] = expected soft decision for output i
+    int16_t branch_table[CODE_RATE*TOTAL_STATES/2];
+    int16_t soft_decision_max_error;
+    // queue of frames in order of submission
+    std::vector<Frame> frames;
+    int queue_head = 0;
+    int queue_length = 0;
+    // soft_bits[(step*CODE_RATE + i)*TOTAL_LANES + lane]
+    AlignedVector<int16_t> soft_bits;
+    // decisions[(step*TOTAL_STATES + state)*TOTAL_LANES + lane] = 0 or -1 if the upper branch was taken
+    AlignedVector<int16_t> decisions;
+public:
+    // max_frames = maximum number of frames that can be queued
+    // _max_encoded_bytes = largest encoded frame that can be submitted
+    BatchViterbiDecoder(const uint8_t poly[CODE_RATE], const int max_frames, const int _max_encoded_bytes);
+    BatchViterbiDecoder(BatchViterbiDecoder&) = delete;
+    BatchViterbiDecoder(BatchViterbiDecoder&&) = delete;
+    BatchViterbiDecoder& operator=(BatchViterbiDecoder&) = delete;
+    BatchViterbiDecoder& operator=(BatchViterbiDecoder&&) = delete;
+    // Queue an encoded frame, returns false if the queue is full
+    // tag = user value which is passed back when the frame is collected
+    bool Submit(tcb::span<const uint8_t> encoded_bytes, const int tag=0);
+    // Decode all queued frames in groups of TOTAL_LANES
+    void Process();
+    // Return decoded frames in order of submission and remove them from the queue
+    // The decoded bytes are only valid during the callback
+    void Collect(const Callback& callback);
+    int GetTotalQueued() const { return queue_length; }
+    int GetTotalPending() const;
+    int GetCapacity() const { return (int)frames.size(); }
+private:
+    void DecodeLanes(Frame** lanes, const int nb_lanes);
+};
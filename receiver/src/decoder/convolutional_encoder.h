@@ -2,22 +2,68 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <vector>
 
-#define CODE_RATE 2
-
-// R = 1/2
-// K = 3
+// Convolutional encoder with constraint length K and code rate 1/R
+// The newest input bit is the least significant bit of the shift register
+// Each output bit is the parity of the shift register masked by its polynomial
+// Bytes are encoded at a time using a lookup table
+// K = constraint length
+// R = number of output bits per input bit
+template <int K, int R>
 class ConvolutionalEncoder {
+public:
+    static_assert(K >= 2 && K <= 9, "Lookup table is indexed by K-1 register bits and 8 input bits");
+    static_assert(R >= 1 && R <= 4, "Encoded output of a byte must fit into 32 bits");
+    static constexpr int TOTAL_STATES = 1 << (K-1);
 private:
-    uint16_t reg = 0;
-    uint8_t G[CODE_RATE];
-
-    // 10bit lookup
-    // 2bit = register state | 8bits = input
-    // output of look up is the 16 bit encoded output
-    uint16_t LOOKUP_TABLE[1024]; 
+    uint32_t reg = 0;
+    uint16_t G[R];
+    // (K-1)bit register state | 8bit input
+    // output of look up is the 8*R bit encoded output
+    std::vector<uint32_t> lookup_table;
 public:
-    ConvolutionalEncoder(const uint8_t poly[CODE_RATE]);
+    ConvolutionalEncoder(const uint16_t poly[R]) {
+        for (int i = 0; i < R; i++) {
+            G[i] = poly[i];
+        }
+
+        // Generate lookup table
+        const uint32_t reg_mask = (1u << K) - 1u;
+        lookup_table.resize(TOTAL_STATES*256);
+        for (uint32_t i = 0; i < (uint32_t)(TOTAL_STATES*256); i++) {
+            uint32_t y = 0;
+            for (int j = 0; j < 8; j++) {
+                const uint32_t r = (i >> (7-j)) & reg_mask;
+                for (int k = 0; k < R; k++) {
+                    y = (y << 1) | get_parity(r & G[k]);
+                }
+            }
+            lookup_table[i] = y;
+        }
+    }
     void reset(void) { reg = 0; }
-    uint16_t consume_byte(uint8_t x); 
-};
\ No newline at end of file
+    // y = R output bytes
+    // return number of bytes written
+    int consume_byte(const uint8_t x, uint8_t* y) {
+        const uint32_t v = consume_byte_packed(x);
+        for (int i = 0; i < R; i++) {
+            y[i] = (uint8_t)(v >> (8*(R-1-i)));
+        }
+        return R;
+    }
+    // return the R output bytes packed msb first
+    uint32_t consume_byte_packed(const uint8_t x) {
+        reg = ((reg << 8) | (uint32_t)x) & (TOTAL_STATES*256 - 1);
+        return lookup_table[reg];
+    }
+private:
+    static uint32_t get_parity(uint32_t x) {
+        uint32_t parity = 0;
+        while (x) {
+            parity ^= (x & 0b1);
+            x = x >> 1;
+        }
+        return parity;
+    }
+};
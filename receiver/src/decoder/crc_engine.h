@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stdint.h>
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "dsp/simd/simd_config.h"
+
+// Non-reflected crc with an initial value of 0 and no final xor
+// T = uint8_t or uint32_t for the crc width
+// Processes the message with one of the following methods:
+// 1. bytewise = single lookup table, one byte per iteration
+// 2. slice8   = 8 lookup tables, 8 bytes per iteration
+// 3. clmul    = carryless multiply folding of 128bit blocks down to a single block
+// All methods give the same crc and can be chained by passing the crc of the previous data
+template <typename T>
+class CRC_Engine
+{
+public:
+    static constexpr int WIDTH = int(sizeof(T)*8);
+    // Folding needs a 16 byte block for each of the 4 accumulators
+    static constexpr int CLMUL_MIN_LENGTH = 64;
+private:
+    const T G; // generator polynomial without leading coefficient (msb left)
+    // tables[k][i] = crc of byte i followed by k null bytes
+    T tables[8][256] = {{0}};
+    // x^k mod G for the folding distances used by process_clmul
+    // Each pair is {x^d mod G, x^(d+64) mod G} for the low and high 64bits of a block
+    uint64_t fold_512[2] = {0};
+    uint64_t fold_384[2] = {0};
+    uint64_t fold_256[2] = {0};
+    uint64_t fold_128[2] = {0};
+public:
+    CRC_Engine(const T _G): G(_G) {
+        generate_tables();
+        generate_fold_constants();
+    }
+
+    T process(const uint8_t* x, const int N, const T crc=0) const {
+        #if defined(_DSP_PCLMUL) && defined(_DSP_SSSE3)
+        if (N >= CLMUL_MIN_LENGTH) {
+            return process_clmul(x, N, crc);
+        }
+        #endif
+        return process_slice8(x, N, crc);
+    }
+
+    T process_bytewise(const uint8_t* x, const int N, T crc=0) const {
+        for (int i = 0; i < N; i++) {
+            crc = update_byte(crc, x[i]);
+        }
+        return crc;
+    }
+
+    T process_slice8(const uint8_t* x, const int N, T crc=0) const {
+        constexpr int K = 8;
+        const int N_vector = (N/K)*K;
+
+        for (int i = 0; i < N_vector; i += K) {
+            // crc only overlaps the first WIDTH bits of the message
+            const uint64_t v = load_be64(&x[i]) ^ (uint64_t(crc) << (64-WIDTH));
+            crc = tables[7][(v >> 56) & 0xFF] ^ tables[6][(v >> 48) & 0xFF]
+                ^ tables[5][(v >> 40) & 0xFF] ^ tables[4][(v >> 32) & 0xFF]
+                ^ tables[3][(v >> 24) & 0xFF] ^ tables[2][(v >> 16) & 0xFF]
+                ^ tables[1][(v >>  8) & 0xFF] ^ tables[0][ v        & 0xFF];
+        }
+        return process_bytewise(&x[N_vector], N-N_vector, crc);
+    }
+
+    #if defined(_DSP_PCLMUL) && defined(_DSP_SSSE3)
+    T process_clmul(const uint8_t* x, const int N, T crc=0) const;
+    #endif
+private:
+    inline T update_byte(const T crc, const uint8_t x) const {
+        // NOTE: for 8bit crc the shifted state is cast to 0
+        return T(crc << 8) ^ tables[0][uint8_t(crc >> (WIDTH-8)) ^ x];
+    }
+
+    static inline uint64_t load_be64(const uint8_t* x) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) {
+            v = (v << 8) | uint64_t(x[i]);
+        }
+        return v;
+    }
+
+    void generate_tables(void) {
+        const T bitcheck = T(1) << (WIDTH-1);
+        for (int i = 0; i < 256; i++) {
+            T crc = T(T(i) << (WIDTH-8));
+            for (int j = 0; j < 8; j++) {
+                if ((crc & bitcheck) != 0) {
+                    crc = T(crc << 1) ^ G;
+                } else {
+                    crc = T(crc << 1);
+                }
+            }
+            tables[0][i] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int i = 0; i < 256; i++) {
+                tables[k][i] = update_byte(tables[k-1][i], 0x00);
+            }
+        }
+    }
+
+    // x^k mod G
+    uint64_t get_xpow_mod(const int k) const {
+        const uint64_t top_bit = uint64_t(1) << WIDTH;
+        uint64_t r = 1;
+        for (int i = 0; i < k; i++) {
+            r = r << 1;
+            if ((r & top_bit) != 0) {
+                r = r ^ top_bit ^ uint64_t(G);
+            }
+        }
+        return r;
+    }
+
+    void generate_fold_constants(void) {
+        auto set_pair = [this](uint64_t pair[2], const int d) {
+            pair[0] = get_xpow_mod(d);
+            pair[1] = get_xpow_mod(d+64);
+        };
+        set_pair(fold_512, 512);
+        set_pair(fold_384, 384);
+        set_pair(fold_256, 256);
+        set_pair(fold_128, 128);
+    }
+};
+
+#if defined(_DSP_PCLMUL) && defined(_DSP_SSSE3)
+// Each 128bit block is byte reversed so the first byte of the message is in the highest bits
+// A block A that is d bits ahead of block B is folded onto it as
+//   A*x^d = A_hi*x^(d+64) + A_lo*x^d = A_hi*(x^(d+64) mod G) + A_lo*(x^d mod G) (mod G)
+// Both products are less than 128bits so the folded result stays within a single block
+// The final block has the same crc as the message so it is finished off using the tables
+template <typename T>
+T CRC_Engine<T>::process_clmul(const uint8_t* x, const int N, T crc) const {
+    constexpr int K = 16;
+    constexpr int TOTAL_ACC = 4;
+    static_assert(CLMUL_MIN_LENGTH == K*TOTAL_ACC);
+    if (N < CLMUL_MIN_LENGTH) {
+        return process_slice8(x, N, crc);
+    }
+
+    const __m128i reverse = _mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+    auto load = [&reverse, x](const int i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+        return _mm_shuffle_epi8(v, reverse);
+    };
+    auto fold = [](const __m128i a, const __m128i k) {
+        return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11));
+    };
+    auto get_constant = [](const uint64_t pair[2]) {
+        return _mm_set_epi64x((long long)pair[1], (long long)pair[0]);
+    };
+
+    // initial crc is added to the first WIDTH bits of the message
+    const __m128i init = _mm_set_epi32(int(uint32_t(crc) << (32-WIDTH)), 0, 0, 0);
+    __m128i acc[TOTAL_ACC];
+    for (int j = 0; j < TOTAL_ACC; j++) {
+        acc[j] = load(j*K);
+    }
+    acc[0] = _mm_xor_si128(acc[0], init);
+
+    // independent accumulators hide the latency of the multiply
+    int i = K*TOTAL_ACC;
+    const __m128i k512 = get_constant(fold_512);
+    for (; (i + K*TOTAL_ACC) <= N; i += K*TOTAL_ACC) {
+        for (int j = 0; j < TOTAL_ACC; j++) {
+            acc[j] = _mm_xor_si128(fold(acc[j], k512), load(i + j*K));
+        }
+    }
+
+    const __m128i k128 = get_constant(fold_128);
+    __m128i res = acc[TOTAL_ACC-1];
+    res = _mm_xor_si128(res, fold(acc[0], get_constant(fold_384)));
+    res = _mm_xor_si128(res, fold(acc[1], get_constant(fold_256)));
+    res = _mm_xor_si128(res, fold(acc[2], k128));
+
+    for (; (i + K) <= N; i += K) {
+        res = _mm_xor_si128(fold(res, k128), load(i));
+    }
+
+    uint8_t block[K];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(block), _mm_shuffle_epi8(res, reverse));
+    crc = process_slice8(block, K, 0);
+    return process_slice8(&x[i], N-i, crc);
+}
+#endif
@@ -1,9 +1,13 @@
 #include "frame_decoder.h"
 #include <assert.h>
+#include <algorithm>
 
 #include "preamble_detector.h"
 #include "additive_scrambler.h"
-#include "viterbi_decoder.h"
+#include "dsp/simd/u8_lut_pack.h"
+#include "hard_decision_viterbi_decoder.h"
+#include "batch_viterbi_decoder.h"
+#include "streaming_viterbi_decoder.h"
 #include "crc8.h"
 
 FrameDecoder::FrameDecoder(
@@ -19,26 +23,30 @@ FrameDecoder::FrameDecoder(
     state = State::WAIT_BLOCK_SIZE;
 
     constexpr int TOTAL_PHASES = 4;
-    preamble_detector = std::make_unique<PreambleDetector>(preamble_word, TOTAL_PHASES);
-    descrambler = std::make_unique<AdditiveScrambler>(scrambler_syncword);
+    preamble_detector = std::make_unique<PreambleDetector>(preamble_word, TOTAL_PHASES, constellation);
+    descrambler = std::make_unique<AdditiveScramblerKeystream>(scrambler_syncword, buffer_size);
 
-    vitdec = std::make_unique<ViterbiDecoder>(conv_poly, buffer_size*8);
+    vitdec = std::make_unique<HardDecisionViterbiDecoder>(conv_poly, buffer_size*8);
+    conv_polys[0] = conv_poly[0];
+    conv_polys[1] = conv_poly[1];
     crc8_calc = std::make_unique<CRC8_Calculator>(crc8_poly);
 
     descramble_buffer.resize(buffer_size);
     encoded_buffer.resize(buffer_size);
     decoded_buffer.resize(buffer_size);
+    symbol_buffer.resize(buffer_size);
+
 }
 
 FrameDecoder::~FrameDecoder() = default;
 
 FrameDecoder::ProcessResult FrameDecoder::process(const std::complex<float> IQ) {
     if (state == State::WAIT_PREAMBLE) {
-        return process_await_preamble(IQ);
+        return process_await_preamble(constellation.GetNearestSymbol(IQ));
     }
 
-    const auto phase_shift = preamble_detector->GetPhase();
-    const uint8_t x = constellation.GetNearestSymbol(IQ * phase_shift);
+    const auto rotation = preamble_detector->GetSymbolRotation(preamble_detector->GetPhaseIndex());
+    const uint8_t x = rotation[constellation.GetNearestSymbol(IQ)];
     const int nb_bits = constellation.GetBitsPerSymbol();
 
     auto res = ProcessResult::NONE;
@@ -54,8 +62,142 @@ FrameDecoder::ProcessResult FrameDecoder::process(const std::complex<float> IQ)
     }
 }
 
-FrameDecoder::ProcessResult FrameDecoder::process_await_preamble(const std::complex<float> IQ) {
-    auto res = preamble_detector->Process(IQ, constellation);
+void FrameDecoder::process(
+    tcb::span<const std::complex<float>> x, 
+    const std::function<void(ProcessResult, const Payload&)>& callback) 
+{
+    const int N = (int)x.size();
+    const int nb_bits = constellation.GetBitsPerSymbol();
+
+    // smallest run of symbols that fills a whole number of bytes
+    int symbols_per_run = 1;
+    while (((symbols_per_run*nb_bits) % 8) != 0) {
+        symbols_per_run++;
+    }
+    const int bytes_per_run = symbols_per_run*nb_bits/8;
+
+    for (int i = 0; i < N; i += (int)symbol_buffer.size()) {
+        const int M = std::min(N-i, (int)symbol_buffer.size());
+        constellation.SliceSymbols(x.subspan(i, M), { symbol_buffer.data(), (size_t)M });
+        int j = 0;
+        while (j < M) {
+            if (state == State::WAIT_PREAMBLE) {
+                const auto res = process_await_preamble(symbol_buffer[j]);
+                j++;
+                if (res != ProcessResult::NONE) {
+                    callback(res, payload);
+                }
+                continue;
+            }
+
+            const auto rotation = preamble_detector->GetSymbolRotation(preamble_detector->GetPhaseIndex());
+
+            // Runs can only be packed up to the end of the current field
+            int nb_runs = 0;
+            if (encoded_bits == 0) {
+                const int target_bytes = (state == State::WAIT_BLOCK_SIZE) ? nb_bytes_for_block_size : encoded_block_size;
+                nb_runs = (target_bytes-encoded_bytes) / bytes_per_run;
+                nb_runs = std::min(nb_runs, (M-j) / symbols_per_run);
+            }
+
+            // Partially filled bytes are handled one symbol at a time
+            if (nb_runs <= 0) {
+                const uint8_t sym = rotation[symbol_buffer[j]];
+                j++;
+                const auto res = (state == State::WAIT_BLOCK_SIZE) ? 
+                    process_await_block_size(sym, nb_bits) : 
+                    process_await_payload(sym, nb_bits, &callback);
+                if (res != ProcessResult::NONE) {
+                    callback(res, payload);
+                }
+                continue;
+            }
+
+            const int nb_symbols = nb_runs*symbols_per_run;
+            const int nb_bytes = nb_runs*bytes_per_run;
+            assert((encoded_bytes+nb_bytes) <= buffer_size);
+
+            u8_lut_pack_auto(
+                &symbol_buffer[j], &descramble_buffer[encoded_bytes], 
+                rotation.data(), nb_symbols, nb_bits);
+            j += nb_symbols;
+
+            descrambler->process(
+                { &descramble_buffer[encoded_bytes], (size_t)nb_bytes },
+                { &encoded_buffer[encoded_bytes], (size_t)nb_bytes },
+                encoded_bytes);
+            encoded_bytes += nb_bytes;
+            if (streaming_vitdec) {
+                stream_decode(encoded_bytes-nb_bytes, nb_bytes);
+            }
+
+            const auto res = (state == State::WAIT_BLOCK_SIZE) ? decode_block_size() : decode_payload(&callback);
+            if (res != ProcessResult::NONE) {
+                callback(res, payload);
+            }
+        }
+    }
+
+    if (batch_vitdec && (batch_vitdec->GetTotalPending() >= BatchViterbiDecoder::TOTAL_LANES)) {
+        Flush(callback);
+    }
+}
+
+void FrameDecoder::SetBatchViterbi(const bool is_enabled) {
+    assert(!is_enabled || !streaming_vitdec);
+    if (!is_enabled) {
+        assert(!batch_vitdec || (batch_vitdec->GetTotalQueued() == 0));
+        batch_vitdec = nullptr;
+        return;
+    }
+
+    if (!batch_vitdec) {
+        // Allow a few extra frames past a full batch before we are forced to decode
+        const int max_frames = 4*BatchViterbiDecoder::TOTAL_LANES;
+        batch_vitdec = std::make_unique<BatchViterbiDecoder>(conv_polys, max_frames, buffer_size);
+    }
+}
+
+void FrameDecoder::SetStreamingViterbi(const bool is_enabled, const int traceback_depth) {
+    assert(!is_enabled || !batch_vitdec);
+    if (!is_enabled) {
+        streaming_vitdec = nullptr;
+        return;
+    }
+
+    if (!streaming_vitdec || (streaming_vitdec->GetTracebackDepth() != traceback_depth)) {
+        const uint16_t polys[2] = { conv_polys[0], conv_polys[1] };
+        streaming_vitdec = std::make_unique<StreamingViterbiDecoder<3,2>>(polys, traceback_depth);
+    }
+}
+
+void FrameDecoder::Flush(const std::function<void(ProcessResult, const Payload&)>& callback) {
+    if (!batch_vitdec) {
+        return;
+    }
+
+    batch_vitdec->Process();
+    batch_vitdec->Collect([this, &callback](const int block_size, tcb::span<uint8_t> decoded, const int16_t path_error) {
+        const auto res = check_payload(decoded.data(), block_size, (int)path_error);
+        callback(res, payload);
+    });
+}
+
+void FrameDecoder::submit_payload(const std::function<void(ProcessResult, const Payload&)>& callback) {
+    // The whole frame is decoded again by the batch decoder from the start
+    const tcb::span<const uint8_t> frame = { encoded_buffer.data(), (size_t)encoded_block_size };
+    if (!batch_vitdec->Submit(frame, decoded_block_size)) {
+        Flush(callback);
+        const bool is_submitted = batch_vitdec->Submit(frame, decoded_block_size);
+        assert(is_submitted);
+    }
+
+    state = State::WAIT_PREAMBLE;
+    reset();
+}
+
+FrameDecoder::ProcessResult FrameDecoder::process_await_preamble(const uint8_t sym) {
+    auto res = preamble_detector->ProcessSymbol(sym);
     if (!res) {
         return ProcessResult::NONE;
     }
@@ -67,23 +209,35 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_preamble(const std::comp
 
 FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(const uint8_t x, const int nb_bits) {
     process_decoder_bits(x, nb_bits);
+    return decode_block_size();
+}
 
-    // Get block size once we have enough bytes decoded
-    bool is_done = 
-        (encoded_bytes >= nb_bytes_for_block_size) &&
-        (encoded_bits == 0);
-    
-    if (!is_done) {
-        return ProcessResult::NONE;
-    }
-
-    const int nb_decoded_bytes = nb_bytes_for_block_size/CODE_RATE;
-    assert(nb_bytes_for_block_size <= buffer_size);
-    assert(nb_decoded_bytes <= buffer_size );
+FrameDecoder::ProcessResult FrameDecoder::decode_block_size() {
+    constexpr int frame_length_field_size = 2;
 
-    vitdec->Update({ &encoded_buffer[0], (size_t)nb_bytes_for_block_size });
-    vitdec->GetTraceback({ &decoded_buffer[0], (size_t)nb_decoded_bytes });
-    decoded_bytes += nb_decoded_bytes;
+    if (streaming_vitdec) {
+        // Streaming decoder has already decoded the received bytes
+        if (decoded_bytes < frame_length_field_size) {
+            return ProcessResult::NONE;
+        }
+    } else {
+        // Get block size once we have enough bytes decoded
+        bool is_done = 
+            (encoded_bytes >= nb_bytes_for_block_size) &&
+            (encoded_bits == 0);
+        
+        if (!is_done) {
+            return ProcessResult::NONE;
+        }
+
+        const int nb_decoded_bytes = nb_bytes_for_block_size/CODE_RATE;
+        assert(nb_bytes_for_block_size <= buffer_size);
+        assert(nb_decoded_bytes <= buffer_size );
+
+        vitdec->Update({ &encoded_buffer[0], (size_t)nb_bytes_for_block_size });
+        vitdec->GetTraceback({ &decoded_buffer[0], (size_t)nb_decoded_bytes });
+        decoded_bytes += nb_decoded_bytes;
+    }
 
     const uint16_t rx_block_size = *reinterpret_cast<uint16_t*>(&decoded_buffer[0]);
     payload.length = rx_block_size;
@@ -108,8 +262,15 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(const uint8_t
     }
 }
 
-FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x, const int nb_bits) {
+FrameDecoder::ProcessResult FrameDecoder::process_await_payload(
+    const uint8_t x, const int nb_bits,
+    const std::function<void(ProcessResult, const Payload&)>* batch_callback) 
+{
     process_decoder_bits(x, nb_bits);
+    return decode_payload(batch_callback);
+}
+
+FrameDecoder::ProcessResult FrameDecoder::decode_payload(const std::function<void(ProcessResult, const Payload&)>* batch_callback) {
     bool is_done = 
         (encoded_bytes >= encoded_block_size) &&
         (encoded_bits == 0);
@@ -118,6 +279,28 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x,
         return ProcessResult::NONE;
     }
 
+    // Every completed payload is queued so results stay in the order the frames were received
+    // This includes frames which finish on a partial byte outside of a packed run
+    if (batch_vitdec && batch_callback) {
+        submit_payload(*batch_callback);
+        return ProcessResult::NONE;
+    }
+
+    if (streaming_vitdec) {
+        // Only the bits within the traceback depth of the end are left to decode
+        // NOTE: We have a known byte of 0x00 as the Trellis terminator so the end state is 0
+        decoded_bytes += streaming_vitdec->Flush({ &decoded_buffer[decoded_bytes], (size_t)(buffer_size-decoded_bytes) }, 0);
+        assert(decoded_bytes == (encoded_block_size/CODE_RATE));
+
+        const auto dist_err = (int)streaming_vitdec->GetPathError();
+        const int block_size = decoded_block_size;
+
+        state = State::WAIT_PREAMBLE;
+        reset();
+
+        return check_payload(decoded_buffer.data(), block_size, dist_err);
+    }
+
     // Once we have received the known number of encoded bytes, decode the rest of the frame
     // We flush the viterbi decoder to get all of the predicted bits
     // NOTE: We have a known byte of 0x00 as the Trellis terminator
@@ -133,6 +316,16 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x,
 
     assert(decoded_bytes <= buffer_size);
 
+    const auto dist_err = (int)vitdec->GetPathError();
+    const int block_size = decoded_block_size;
+
+    state = State::WAIT_PREAMBLE;
+    reset();
+
+    return check_payload(decoded_buffer.data(), block_size, dist_err);
+}
+
+FrameDecoder::ProcessResult FrameDecoder::check_payload(uint8_t* decoded, const int block_size, const int dist_err) {
     // packet structure
     // 0:1 -> uint16_t length
     // 2:2+N -> uint8_t* payload
@@ -140,19 +333,14 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x,
     // K:K -> uint8_t crc8
     // K+1:K+1 -> uint8_t trellis null terminator 
     constexpr int frame_length_field_size = 2;
-    const int crc8_length = 1;
-    const int trellis_terminator_length = 1;
 
-    uint8_t* payload_buf = &decoded_buffer[frame_length_field_size];
+    uint8_t* payload_buf = &decoded[frame_length_field_size];
 
-    const uint8_t crc8_true = decoded_buffer[decoded_bytes-(crc8_length+trellis_terminator_length)];
-    const uint8_t crc8_pred = crc8_calc->process(payload_buf, decoded_block_size);
-    const auto dist_err = (int)vitdec->GetPathError();
+    const uint8_t crc8_true = decoded[frame_length_field_size+block_size];
+    const uint8_t crc8_pred = crc8_calc->process(payload_buf, block_size);
     const bool crc8_mismatch = (crc8_true != crc8_pred);
 
-    state = State::WAIT_PREAMBLE;
-    reset();
-
+    payload.length = block_size;
     payload.buf = payload_buf;
     payload.crc8_calculated = crc8_pred;
     payload.crc8_received = crc8_true;
@@ -178,13 +366,23 @@ void FrameDecoder::process_decoder_bits(const uint8_t x, const int nb_bits) {
     // if a byte has been processed, then unscramble and move onto next byte
     if (encoded_bits == 8) {
         encoded_bits = 0;
-        encoded_buffer[encoded_bytes] = descrambler->process(descramble_buffer[encoded_bytes]);
+        encoded_buffer[encoded_bytes] = descrambler->process(descramble_buffer[encoded_bytes], encoded_bytes);
         encoded_bytes += 1;
+        if (streaming_vitdec) {
+            stream_decode(encoded_bytes-1, 1);
+        }
     }
 
     assert(encoded_bytes <= buffer_size);
 }
 
+void FrameDecoder::stream_decode(const int offset, const int nb_bytes) {
+    decoded_bytes += streaming_vitdec->Update(
+        { &encoded_buffer[offset], (size_t)nb_bytes }, 
+        { &decoded_buffer[decoded_bytes], (size_t)(buffer_size-decoded_bytes) });
+    assert(decoded_bytes <= buffer_size);
+}
+
 void FrameDecoder::reset() {
     encoded_bits = 0;
     encoded_bytes = 0;
@@ -193,6 +391,8 @@ void FrameDecoder::reset() {
     decoded_block_size = 0;
     encoded_block_size = 0;
 
-    descrambler->reset();
     vitdec->Reset();
+    if (streaming_vitdec) {
+        streaming_vitdec->Reset();
+    }
 }
\ No newline at end of file
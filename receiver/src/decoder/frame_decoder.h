@@ -4,11 +4,15 @@
 #include <complex>
 #include <memory>
 #include <vector>
+#include <functional>
+#include "utility/span.h"
 
 class ConstellationSpecification;
 class PreambleDetector;
-class AdditiveScrambler;
-class ViterbiDecoder;
+class AdditiveScramblerKeystream;
+class HardDecisionViterbiDecoder;
+class BatchViterbiDecoder;
+template <int K, int R> class StreamingViterbiDecoder;
 class CRC8_Calculator;
 
 // Decodes a encoded payload 
@@ -54,14 +58,21 @@ public:
 private:
     ConstellationSpecification& constellation;
     std::unique_ptr<PreambleDetector> preamble_detector;
-    std::unique_ptr<AdditiveScrambler> descrambler;
-    std::unique_ptr<ViterbiDecoder> vitdec;
+    std::unique_ptr<AdditiveScramblerKeystream> descrambler;
+    std::unique_ptr<HardDecisionViterbiDecoder> vitdec;
+    // Optionally decode completed payloads in batches over many frames
+    std::unique_ptr<BatchViterbiDecoder> batch_vitdec;
+    // Optionally decode the frame as it arrives with a bounded traceback depth
+    std::unique_ptr<StreamingViterbiDecoder<3,2>> streaming_vitdec;
+    uint8_t conv_polys[2];
     std::unique_ptr<CRC8_Calculator> crc8_calc;
     // internal buffers for decoding
     const int buffer_size;
     std::vector<uint8_t> descramble_buffer;
     std::vector<uint8_t> encoded_buffer;
     std::vector<uint8_t> decoded_buffer;
+    // symbols sliced without phase correction for block processing
+    std::vector<uint8_t> symbol_buffer;
     // keep track of position in buffers
     int encoded_bits = 0;
     int encoded_bytes = 0;
@@ -82,15 +93,49 @@ public:
         const uint8_t crc8_poly);
     ~FrameDecoder();
     ProcessResult process(const std::complex<float> IQ);
+    // Process a block of symbols at once
+    // Symbols are sliced together and the phase is corrected with a lookup table on the sliced symbols
+    // Runs of whole bytes inside a frame are packed and descrambled together
+    // Only the preamble search and partial bytes at the edges of a field go symbol by symbol
+    // callback is invoked for every result other than NONE
+    void process(
+        tcb::span<const std::complex<float>> x, 
+        const std::function<void(ProcessResult, const Payload&)>& callback);
+    // In batch mode completed payloads from process(span, callback) are queued 
+    // and decoded together once enough frames have been collected
+    // Payload results keep their order but are delivered out of order with the other results
+    // NOTE: Call Flush() before disabling batch mode or at the end of the stream
+    void SetBatchViterbi(const bool is_enabled);
+    bool IsBatchViterbi() const { return batch_vitdec != nullptr; }
+    void Flush(const std::function<void(ProcessResult, const Payload&)>& callback);
+    // In streaming mode encoded bytes are decoded as soon as they arrive
+    // Decoded bytes lag the received bytes by the traceback depth instead of by the whole frame
+    // The block size is read as soon as it is decoded and only the tail is decoded at the end of the frame
+    // traceback_depth = number of trellis steps used for the survivor paths to merge, usually 5 to 7 times K
+    // NOTE: Streaming and batch mode cannot be enabled together
+    //       Change the mode while waiting for a preamble since the current frame is not carried over
+    void SetStreamingViterbi(const bool is_enabled, const int traceback_depth=18);
+    bool IsStreamingViterbi() const { return streaming_vitdec != nullptr; }
     inline State GetState() { return state; }
     inline Payload GetPayload() { return payload; }
 private:
-    ProcessResult process_await_preamble(const std::complex<float> IQ);
+    // sym = symbol sliced without any phase correction
+    ProcessResult process_await_preamble(const uint8_t sym);
     // Decode the block size so we can anticipate when to stop decoding
     ProcessResult process_await_block_size(const uint8_t x, const int nb_bits);
+    ProcessResult decode_block_size();
     // Decode the rest of the payload after block size is known
-    ProcessResult process_await_payload(const uint8_t x, const int nb_bits); 
+    // In batch mode a completed payload is queued instead if a callback is given
+    ProcessResult process_await_payload(
+        const uint8_t x, const int nb_bits,
+        const std::function<void(ProcessResult, const Payload&)>* batch_callback=NULL); 
+    ProcessResult decode_payload(const std::function<void(ProcessResult, const Payload&)>* batch_callback=NULL);
+    // Queue the completed payload into the batch decoder
+    void submit_payload(const std::function<void(ProcessResult, const Payload&)>& callback);
+    ProcessResult check_payload(uint8_t* decoded, const int block_size, const int dist_err);
     // Construct individual bytes for processing from bits
     void process_decoder_bits(const uint8_t x, const int nb_bits); 
+    // Push newly received encoded bytes through the streaming decoder
+    void stream_decode(const int offset, const int nb_bytes);
     void reset();
 };
\ No newline at end of file
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "utility/span.h"
+#include "utility/aligned_vector.h"
+#include "viterbi_config.h"
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "dsp/simd/simd_config.h"
+
+// Trellis of path metrics for a convolutional code with constraint length K and code rate 1/R
+// Follows the same conventions as phil_karn_viterbi_decoder.cpp so K=3 R=2 gives identical results
+// - State transition is new_state = (old_state << 1) | input
+// - Butterfly i connects old states (i, i+N/2) to new states (2i, 2i+1)
+// - Path metrics are int16_t and renormalised once they approach overflow
+// The add compare select step uses SSE once there are 16 states and AVX2 once there are 32 states
+// NOTE: Polynomials must have the first and last taps set, i.e. bit 0 and bit K-1
+//       This is true for all useful codes and is needed for the butterfly symmetry
+template <int K, int R>
+class ViterbiTrellis
+{
+public:
+    static_assert(K >= 3 && K <= 16, "Constraint length is out of range");
+    static constexpr int TOTAL_STATES = 1 << (K-1);
+    static constexpr int TOTAL_BUTTERFLIES = TOTAL_STATES/2;
+    // Decision bits for each step are packed into 32bit words
+    static constexpr int DECISION_WORDS = (TOTAL_STATES+31)/32;
+private:
+    static constexpr int16_t RENORMALIZE_THRESHOLD = SHRT_MAX-3000;
+    static constexpr int16_t INITIAL_START_ERROR = 0;
+    static constexpr int16_t INITIAL_NON_START_ERROR = 0+3000;
+    // branch_table[i*TOTAL_BUTTERFLIES + butterfly] = expected soft decision for output i
+    AlignedVector<int16_t> branch_table;
+    AlignedVector<int16_t> metrics_0;
+    AlignedVector<int16_t> metrics_1;
+    int16_t* old_metrics;
+    int16_t* new_metrics;
+    int16_t soft_decision_max_error;
+public:
+    ViterbiTrellis(const uint16_t poly[R])
+    : branch_table(R*TOTAL_BUTTERFLIES),
+      metrics_0(TOTAL_STATES),
+      metrics_1(TOTAL_STATES)
+    {
+        for (int i = 0; i < R; i++) {
+            assert((poly[i] & 0b1) && (poly[i] & (1u << (K-1))));
+        }
+        for (int state = 0; state < TOTAL_BUTTERFLIES; state++) {
+            for (int i = 0; i < R; i++) {
+                const uint32_t v = get_parity((uint32_t)(state << 1) & (uint32_t)poly[i]);
+                branch_table[i*TOTAL_BUTTERFLIES + state] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+            }
+        }
+        soft_decision_max_error = SOFT_DECISION_VITERBI_HIGH - SOFT_DECISION_VITERBI_LOW;
+        Reset();
+    }
+    ViterbiTrellis(ViterbiTrellis&) = delete;
+    ViterbiTrellis(ViterbiTrellis&&) = delete;
+    ViterbiTrellis& operator=(ViterbiTrellis&) = delete;
+    ViterbiTrellis& operator=(ViterbiTrellis&&) = delete;
+
+    void Reset(const int starting_state=0) {
+        for (int i = 0; i < TOTAL_STATES; i++) {
+            metrics_0[i] = INITIAL_NON_START_ERROR;
+        }
+        metrics_0[starting_state & (TOTAL_STATES-1)] = INITIAL_START_ERROR;
+        old_metrics = metrics_0.data();
+        new_metrics = metrics_1.data();
+    }
+
+    // Advance the trellis by one step using R soft decision bits
+    // d = DECISION_WORDS words which have the bit for each state set if the upper branch was taken
+    void Update(const int16_t* syms, uint32_t* d) {
+        #if defined(_DSP_AVX2)
+        if constexpr(TOTAL_BUTTERFLIES >= 16) {
+            update_step_avx2(syms, d);
+        } else
+        #endif
+        #if defined(_DSP_SSSE3)
+        if constexpr(TOTAL_BUTTERFLIES >= 8) {
+            update_step_ssse3(syms, d);
+        } else
+        #endif
+        {
+            for (int i = 0; i < DECISION_WORDS; i++) {
+                d[i] = 0;
+            }
+            update_step_scalar(syms, d);
+        }
+        renormalise();
+
+        int16_t* tmp = old_metrics;
+        old_metrics = new_metrics;
+        new_metrics = tmp;
+    }
+
+    int16_t GetPathError(const int state=0) const {
+        return old_metrics[state & (TOTAL_STATES-1)];
+    }
+
+    // Used to continue from the path errors of another decoder
+    void SetPathError(const int state, const int16_t error) {
+        old_metrics[state & (TOTAL_STATES-1)] = error;
+    }
+
+    // State with the lowest path error
+    int GetBestState() const {
+        int best_state = 0;
+        for (int i = 1; i < TOTAL_STATES; i++) {
+            best_state = (old_metrics[i] < old_metrics[best_state]) ? i : best_state;
+        }
+        return best_state;
+    }
+private:
+    void update_step_scalar(const int16_t* syms, uint32_t* d) {
+        const int16_t max_error = R*soft_decision_max_error;
+        for (int i = 0; i < TOTAL_BUTTERFLIES; i++) {
+            int16_t metric = 0;
+            for (int j = 0; j < R; j++) {
+                int16_t error = branch_table[j*TOTAL_BUTTERFLIES + i] - syms[j];
+                metric += (error > 0) ? error : -error;
+            }
+            const int16_t metric_inv = max_error - metric;
+
+            const int16_t m0 = old_metrics[i] + metric;
+            const int16_t m1 = old_metrics[i+TOTAL_BUTTERFLIES] + metric_inv;
+            const int16_t m2 = old_metrics[i] + metric_inv;
+            const int16_t m3 = old_metrics[i+TOTAL_BUTTERFLIES] + metric;
+
+            const uint32_t decision0 = (m0 > m1) ? 1 : 0;
+            const uint32_t decision1 = (m2 > m3) ? 1 : 0;
+            new_metrics[2*i]   = decision0 ? m1 : m0;
+            new_metrics[2*i+1] = decision1 ? m3 : m2;
+
+            const int bit = 2*i;
+            d[bit/32] |= (decision0 | (decision1 << 1)) << (bit % 32);
+        }
+    }
+
+    #if defined(_DSP_SSSE3)
+    // 8 butterflies are processed at a time producing 16 new states
+    void update_step_ssse3(const int16_t* syms, uint32_t* d) {
+        constexpr int B = 8;
+        const __m128i max_error = _mm_set1_epi16(R*soft_decision_max_error);
+        __m128i v_syms[R];
+        for (int j = 0; j < R; j++) {
+            v_syms[j] = _mm_set1_epi16(syms[j]);
+        }
+
+        for (int i = 0; i < TOTAL_BUTTERFLIES; i += B) {
+            __m128i metric = _mm_setzero_si128();
+            for (int j = 0; j < R; j++) {
+                const __m128i branch = _mm_load_si128(reinterpret_cast<const __m128i*>(&branch_table[j*TOTAL_BUTTERFLIES + i]));
+                metric = _mm_add_epi16(metric, _mm_abs_epi16(_mm_sub_epi16(branch, v_syms[j])));
+            }
+            const __m128i metric_inv = _mm_sub_epi16(max_error, metric);
+            const __m128i old_lo = _mm_load_si128(reinterpret_cast<const __m128i*>(&old_metrics[i]));
+            const __m128i old_hi = _mm_load_si128(reinterpret_cast<const __m128i*>(&old_metrics[i+TOTAL_BUTTERFLIES]));
+
+            const __m128i m0 = _mm_add_epi16(old_lo, metric);
+            const __m128i m1 = _mm_add_epi16(old_hi, metric_inv);
+            const __m128i m2 = _mm_add_epi16(old_lo, metric_inv);
+            const __m128i m3 = _mm_add_epi16(old_hi, metric);
+
+            const __m128i decision0 = _mm_cmpgt_epi16(m0, m1);
+            const __m128i decision1 = _mm_cmpgt_epi16(m2, m3);
+            const __m128i n0 = _mm_min_epi16(m0, m1);
+            const __m128i n1 = _mm_min_epi16(m2, m3);
+
+            // interleave so new states 2i and 2i+1 are adjacent
+            _mm_store_si128(reinterpret_cast<__m128i*>(&new_metrics[2*i]),   _mm_unpacklo_epi16(n0, n1));
+            _mm_store_si128(reinterpret_cast<__m128i*>(&new_metrics[2*i+B]), _mm_unpackhi_epi16(n0, n1));
+
+            const __m128i decisions_packed = _mm_packs_epi16(
+                _mm_unpacklo_epi16(decision0, decision1),
+                _mm_unpackhi_epi16(decision0, decision1));
+            const uint32_t mask = (uint32_t)_mm_movemask_epi8(decisions_packed);
+            const int bit = 2*i;
+            if ((bit % 32) == 0) {
+                d[bit/32] = mask;
+            } else {
+                d[bit/32] |= mask << (bit % 32);
+            }
+        }
+    }
+    #endif
+
+    #if defined(_DSP_AVX2)
+    // 16 butterflies are processed at a time producing 32 new states
+    void update_step_avx2(const int16_t* syms, uint32_t* d) {
+        constexpr int B = 16;
+        const __m256i max_error = _mm256_set1_epi16(R*soft_decision_max_error);
+        __m256i v_syms[R];
+        for (int j = 0; j < R; j++) {
+            v_syms[j] = _mm256_set1_epi16(syms[j]);
+        }
+
+        for (int i = 0; i < TOTAL_BUTTERFLIES; i += B) {
+            __m256i metric = _mm256_setzero_si256();
+            for (int j = 0; j < R; j++) {
+                const __m256i branch = _mm256_load_si256(reinterpret_cast<const __m256i*>(&branch_table[j*TOTAL_BUTTERFLIES + i]));
+                metric = _mm256_add_epi16(metric, _mm256_abs_epi16(_mm256_sub_epi16(branch, v_syms[j])));
+            }
+            const __m256i metric_inv = _mm256_sub_epi16(max_error, metric);
+            const __m256i old_lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(&old_metrics[i]));
+            const __m256i old_hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(&old_metrics[i+TOTAL_BUTTERFLIES]));
+
+            const __m256i m0 = _mm256_add_epi16(old_lo, metric);
+            const __m256i m1 = _mm256_add_epi16(old_hi, metric_inv);
+            const __m256i m2 = _mm256_add_epi16(old_lo, metric_inv);
+            const __m256i m3 = _mm256_add_epi16(old_hi, metric);
+
+            const __m256i decision0 = _mm256_cmpgt_epi16(m0, m1);
+            const __m256i decision1 = _mm256_cmpgt_epi16(m2, m3);
+            const __m256i n0 = _mm256_min_epi16(m0, m1);
+            const __m256i n1 = _mm256_min_epi16(m2, m3);
+
+            // interleave so new states 2i and 2i+1 are adjacent
+            // unpack works within each 128bit lane so we need to permute the lanes back into order
+            const __m256i n_lo = _mm256_unpacklo_epi16(n0, n1);
+            const __m256i n_hi = _mm256_unpackhi_epi16(n0, n1);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&new_metrics[2*i]),   _mm256_permute2x128_si256(n_lo, n_hi, 0x20));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(&new_metrics[2*i+B]), _mm256_permute2x128_si256(n_lo, n_hi, 0x31));
+
+            const __m256i d_lo = _mm256_unpacklo_epi16(decision0, decision1);
+            const __m256i d_hi = _mm256_unpackhi_epi16(decision0, decision1);
+            __m256i decisions_packed = _mm256_packs_epi16(
+                _mm256_permute2x128_si256(d_lo, d_hi, 0x20),
+                _mm256_permute2x128_si256(d_lo, d_hi, 0x31));
+            decisions_packed = _mm256_permute4x64_epi64(decisions_packed, 0b11011000);
+            d[(2*i)/32] = (uint32_t)_mm256_movemask_epi8(decisions_packed);
+        }
+    }
+    #endif
+
+    void renormalise() {
+        if (new_metrics[0] <= RENORMALIZE_THRESHOLD) {
+            return;
+        }
+        int16_t min = new_metrics[0];
+        for (int i = 0; i < TOTAL_STATES; i++) {
+            min = (new_metrics[i] < min) ? new_metrics[i] : min;
+        }
+        for (int i = 0; i < TOTAL_STATES; i++) {
+            new_metrics[i] -= min;
+        }
+    }
+
+    static uint32_t get_parity(uint32_t x) {
+        uint32_t parity = 0;
+        while (x) {
+            parity ^= (x & 0b1);
+            x = x >> 1;
+        }
+        return parity;
+    }
+};
+
+// Viterbi decoder which stores the decisions for an entire frame
+// Refer to ViterbiTrellis for the conventions used
+template <int K, int R>
+class GenericViterbiDecoder
+{
+public:
+    using Trellis = ViterbiTrellis<K,R>;
+    static constexpr int TOTAL_STATES = Trellis::TOTAL_STATES;
+    static constexpr int DECISION_WORDS = Trellis::DECISION_WORDS;
+private:
+    const int max_steps;
+    Trellis trellis;
+    // decisions[step*DECISION_WORDS + state/32] has the bit (state % 32) set if the upper branch was taken
+    std::vector<uint32_t> decisions;
+    std::vector<int16_t> soft_bits;
+    int curr_step = 0;
+public:
+    // _max_steps = maximum number of encoded steps until the decoder is reset
+    GenericViterbiDecoder(const uint16_t poly[R], const int _max_steps)
+    : max_steps(_max_steps),
+      trellis(poly),
+      decisions(_max_steps*DECISION_WORDS, 0),
+      soft_bits(_max_steps*R)
+    {
+        curr_step = max_steps;
+        Reset();
+    }
+    GenericViterbiDecoder(GenericViterbiDecoder&) = delete;
+    GenericViterbiDecoder(GenericViterbiDecoder&&) = delete;
+    GenericViterbiDecoder& operator=(GenericViterbiDecoder&) = delete;
+    GenericViterbiDecoder& operator=(GenericViterbiDecoder&&) = delete;
+
+    void Reset(const int starting_state=0) {
+        trellis.Reset(starting_state);
+        memset(decisions.data(), 0, curr_step*DECISION_WORDS*sizeof(uint32_t));
+        curr_step = 0;
+    }
+
+    // Hard decision bits packed msb first
+    void Update(tcb::span<const uint8_t> encoded_bytes) {
+        const int nb_bits = (int)encoded_bytes.size()*8;
+        assert((nb_bits % R) == 0);
+        assert(nb_bits <= (int)soft_bits.size());
+        for (int i = 0; i < nb_bits; i++) {
+            const bool v = (encoded_bytes[i/8] & (1 << (7-(i%8)))) != 0;
+            soft_bits[i] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+        UpdateSoft({ soft_bits.data(), (size_t)nb_bits });
+    }
+
+    // Soft decision bits with R bits for each step
+    void UpdateSoft(tcb::span<const int16_t> syms) {
+        const int nb_steps = (int)syms.size()/R;
+        assert((curr_step + nb_steps) <= max_steps);
+        for (int s = 0; s < nb_steps; s++) {
+            trellis.Update(&syms[s*R], &decisions[curr_step*DECISION_WORDS]);
+            curr_step++;
+        }
+    }
+
+    // Chain back from the end state to get nb_bits = out_bytes*8 decoded bits
+    // The first K-1 decisions are skipped since they belong to the tail of the previous frame
+    void GetTraceback(tcb::span<uint8_t> out_bytes, const int end_state=0) {
+        const int nb_bits = (int)out_bytes.size()*8;
+        for (auto& b: out_bytes) {
+            b = 0x00;
+        }
+
+        int curr_state = end_state & (TOTAL_STATES-1);
+        for (int i = nb_bits-1; i >= 0; i--) {
+            const int step = i + (K-1);
+            uint32_t input = 0;
+            if (step < curr_step) {
+                input = (decisions[step*DECISION_WORDS + curr_state/32] >> (curr_state % 32)) & 0b1;
+            }
+            curr_state = (curr_state >> 1) | (int)(input << (K-2));
+            out_bytes[i/8] |= (uint8_t)(input << (7-(i % 8)));
+        }
+    }
+
+    int16_t GetPathError(const int state=0) {
+        return trellis.GetPathError(state);
+    }
+};
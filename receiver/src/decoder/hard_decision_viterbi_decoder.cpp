@@ -0,0 +1,270 @@
+#include "hard_decision_viterbi_decoder.h"
+#include "generic_viterbi_decoder.h"
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <array>
+
+// Same initial metrics and renormalisation as phil_karn_viterbi_decoder.h
+// This keeps the path error identical to the soft decision decoder
+constexpr int RENORMALIZE_THRESHOLD = SHRT_MAX-3000;
+constexpr int16_t INITIAL_START_ERROR = 0;
+constexpr int16_t INITIAL_NON_START_ERROR = 0+3000;
+// Largest increase of the path errors in one trellis step
+constexpr int MAX_BRANCH_ERROR = CODE_RATE*(SOFT_DECISION_VITERBI_HIGH-SOFT_DECISION_VITERBI_LOW);
+constexpr int MAX_NODES = 256;
+constexpr int STEPS_PER_BYTE = 8/CODE_RATE;
+// The step and byte tables pack the next node and the increase of the best path error into 8 bits each
+// The best path error can increase by at most MAX_BRANCH_ERROR per step since the best state has a zero error
+static_assert(MAX_NODES <= 0x100, "Node index must fit into 8 bits of the tables");
+static_assert(MAX_BRANCH_ERROR*STEPS_PER_BYTE <= 0xFF, "Path error increase over a byte must fit into 8 bits of the tables");
+
+static uint8_t get_parity(uint32_t x) {
+    uint8_t parity = 0;
+    while (x) {
+        parity ^= (x & 0b1);
+        x = x >> 1;
+    }
+    return parity;
+}
+
+HardDecisionViterbiDecoder::HardDecisionViterbiDecoder(const uint8_t poly[CODE_RATE], const int _input_bits)
+: max_steps(_input_bits + (CONSTRAINT_LENGTH_K-1))
+{
+    const uint16_t trellis_poly[CODE_RATE] = { poly[0], poly[1] };
+    trellis = std::make_unique<Trellis>(trellis_poly);
+    soft_bits.resize(max_steps*CODE_RATE);
+    decisions.resize((max_steps+3)/4);
+    CreateTables(poly);
+    curr_step = max_steps;
+    Reset();
+}
+
+HardDecisionViterbiDecoder::~HardDecisionViterbiDecoder() = default;
+
+void HardDecisionViterbiDecoder::CreateTables(const uint8_t poly[CODE_RATE]) {
+    using Node = std::array<int16_t, TOTAL_STATES>;
+
+    int16_t branch_table[CODE_RATE][TOTAL_STATES/2];
+    for (int state = 0; state < TOTAL_STATES/2; state++) {
+        for (int i = 0; i < CODE_RATE; i++) {
+            const uint8_t v = get_parity((state << 1) & poly[i]);
+            branch_table[i][state] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+    }
+
+    // Same butterfly as phil_karn_viterbi_decoder.cpp applied to the normalised path errors
+    // Writes the normalised path errors and returns the amount the best path error increased by
+    auto update_node = [&branch_table](const Node& old_errors, Node& new_errors, const int symbol, uint32_t& decisions) {
+        int16_t syms[CODE_RATE];
+        for (int j = 0; j < CODE_RATE; j++) {
+            const bool v = (symbol >> (CODE_RATE-1-j)) & 0b1;
+            syms[j] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+
+        decisions = 0;
+        for (int i = 0; i < TOTAL_STATES/2; i++) {
+            int16_t metric = 0;
+            for (int j = 0; j < CODE_RATE; j++) {
+                const int16_t error = branch_table[j][i] - syms[j];
+                metric += (error > 0) ? error : -error;
+            }
+            const int16_t metric_inv = MAX_BRANCH_ERROR - metric;
+            const int16_t m0 = old_errors[i] + metric;
+            const int16_t m1 = old_errors[i+TOTAL_STATES/2] + metric_inv;
+            const int16_t m2 = old_errors[i] + metric_inv;
+            const int16_t m3 = old_errors[i+TOTAL_STATES/2] + metric;
+            const uint32_t decision0 = (m0 > m1) ? 1 : 0;
+            const uint32_t decision1 = (m2 > m3) ? 1 : 0;
+            new_errors[2*i]   = decision0 ? m1 : m0;
+            new_errors[2*i+1] = decision1 ? m3 : m2;
+            decisions |= (decision0 | (decision1 << 1)) << (2*i);
+        }
+
+        int16_t min_error = new_errors[0];
+        for (auto& v: new_errors) {
+            min_error = (v < min_error) ? v : min_error;
+        }
+        for (auto& v: new_errors) {
+            v -= min_error;
+        }
+        return min_error;
+    };
+
+    // Search for all reachable normalised path errors starting from the initial path errors
+    std::vector<Node> nodes;
+    auto find_node = [&nodes](const Node& node) {
+        for (int i = 0; i < (int)nodes.size(); i++) {
+            if (nodes[i] == node) {
+                return i;
+            }
+        }
+        nodes.push_back(node);
+        assert(nodes.size() <= MAX_NODES);
+        return (int)nodes.size()-1;
+    };
+
+    {
+        Node node;
+        node.fill(INITIAL_NON_START_ERROR);
+        node[0] = INITIAL_START_ERROR;
+        start_node = find_node(node);
+    }
+
+    constexpr int TOTAL_SYMBOLS = 1 << CODE_RATE;
+    step_table.clear();
+    for (int i = 0; i < (int)nodes.size(); i++) {
+        for (int symbol = 0; symbol < TOTAL_SYMBOLS; symbol++) {
+            Node next;
+            uint32_t step_decisions = 0;
+            // NOTE: nodes can be reallocated by find_node
+            const Node curr = nodes[i];
+            const int16_t increase = update_node(curr, next, symbol, step_decisions);
+            const int next_node = find_node(next);
+            step_table.push_back((uint32_t)next_node | ((uint32_t)increase << 8) | (step_decisions << 16));
+        }
+    }
+
+    const int total_nodes = (int)nodes.size();
+    node_errors.resize(total_nodes*TOTAL_STATES);
+    max_node_error = 0;
+    for (int i = 0; i < total_nodes; i++) {
+        for (int j = 0; j < TOTAL_STATES; j++) {
+            const int16_t v = nodes[i][j];
+            node_errors[i*TOTAL_STATES + j] = v;
+            max_node_error = (v > max_node_error) ? v : max_node_error;
+        }
+    }
+
+    // Combine 4 trellis steps for each byte
+    byte_table.resize(total_nodes*256);
+    for (int i = 0; i < total_nodes; i++) {
+        for (int x = 0; x < 256; x++) {
+            int node = i;
+            uint32_t increase = 0;
+            uint32_t byte_decisions = 0;
+            for (int t = 0; t < 4; t++) {
+                const int symbol = (x >> (6-2*t)) & 0b11;
+                const uint32_t v = step_table[node*TOTAL_SYMBOLS + symbol];
+                node = (int)(v & 0xFF);
+                increase += (v >> 8) & 0xFF;
+                byte_decisions |= (v >> 16) << (4*t);
+            }
+            byte_table[i*256 + x] = (uint32_t)node | (increase << 8) | (byte_decisions << 16);
+        }
+    }
+}
+
+void HardDecisionViterbiDecoder::Reset() {
+    curr_node = start_node;
+    base_error = 0;
+    is_soft = false;
+    memset(decisions.data(), 0, ((curr_step+3)/4)*sizeof(uint16_t));
+    curr_step = 0;
+}
+
+void HardDecisionViterbiDecoder::Update(tcb::span<const uint8_t> encoded_bytes) {
+    const int nb_encoded_bytes = (int)encoded_bytes.size();
+    assert((curr_step + nb_encoded_bytes*4) <= max_steps);
+
+    if (is_soft) {
+        for (int i = 0; i < nb_encoded_bytes*8; i++) {
+            const bool v = (encoded_bytes[i/8] & (1 << (7-(i%8)))) != 0;
+            soft_bits[i] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+        }
+        for (int i = 0; i < nb_encoded_bytes*4; i++) {
+            uint32_t d = 0;
+            trellis->Update(&soft_bits[i*CODE_RATE], &d);
+            decisions[curr_step/4] |= (uint16_t)(d << (4*(curr_step%4)));
+            curr_step++;
+        }
+        return;
+    }
+
+    // Renormalisation can only happen once the path errors approach the threshold
+    // Only then do we need to check after each step
+    const int max_byte_error = max_node_error + 4*MAX_BRANCH_ERROR;
+    for (int i = 0; i < nb_encoded_bytes; i++) {
+        const uint8_t x = encoded_bytes[i];
+        if ((base_error + max_byte_error) > RENORMALIZE_THRESHOLD) {
+            for (int t = 0; t < 4; t++) {
+                UpdateStep((x >> (6-2*t)) & 0b11);
+            }
+            continue;
+        }
+
+        // Each byte is 4 steps so we are always aligned to the packed decisions here
+        const uint32_t v = byte_table[curr_node*256 + x];
+        curr_node = (int)(v & 0xFF);
+        base_error += (int)((v >> 8) & 0xFF);
+        decisions[curr_step/4] = (uint16_t)(v >> 16);
+        curr_step += 4;
+    }
+}
+
+void HardDecisionViterbiDecoder::UpdateStep(const int symbol) {
+    const uint32_t v = step_table[curr_node*4 + symbol];
+    curr_node = (int)(v & 0xFF);
+    base_error += (int)((v >> 8) & 0xFF);
+    decisions[curr_step/4] |= (uint16_t)((v >> 16) << (4*(curr_step%4)));
+    curr_step++;
+
+    // Subtracting the best path error leaves the normalised path errors
+    if ((base_error + node_errors[curr_node*TOTAL_STATES]) > RENORMALIZE_THRESHOLD) {
+        base_error = 0;
+    }
+}
+
+void HardDecisionViterbiDecoder::UpdateSoft(tcb::span<const viterbi_bit_t> encoded_bits) {
+    const int nb_steps = (int)encoded_bits.size()/CODE_RATE;
+    assert((curr_step + nb_steps) <= max_steps);
+    SwitchToSoft();
+
+    for (int i = 0; i < nb_steps*CODE_RATE; i++) {
+        soft_bits[i] = (int16_t)encoded_bits[i];
+    }
+    for (int i = 0; i < nb_steps; i++) {
+        uint32_t d = 0;
+        trellis->Update(&soft_bits[i*CODE_RATE], &d);
+        decisions[curr_step/4] |= (uint16_t)(d << (4*(curr_step%4)));
+        curr_step++;
+    }
+}
+
+void HardDecisionViterbiDecoder::SwitchToSoft() {
+    if (is_soft) {
+        return;
+    }
+    trellis->Reset();
+    for (int i = 0; i < TOTAL_STATES; i++) {
+        trellis->SetPathError(i, (int16_t)(base_error + node_errors[curr_node*TOTAL_STATES + i]));
+    }
+    is_soft = true;
+}
+
+void HardDecisionViterbiDecoder::GetTraceback(tcb::span<uint8_t> out_bytes, const int end_state) {
+    const int nb_bits = (int)out_bytes.size()*8;
+    for (auto& b: out_bytes) {
+        b = 0x00;
+    }
+
+    // ignore the tail bits of the previous frame
+    int curr_state = end_state & (TOTAL_STATES-1);
+    for (int i = nb_bits-1; i >= 0; i--) {
+        const int step = i + (CONSTRAINT_LENGTH_K-1);
+        uint32_t input = 0;
+        if (step < curr_step) {
+            const uint32_t d = decisions[step/4] >> (4*(step%4));
+            input = (d >> curr_state) & 0b1;
+        }
+        curr_state = (curr_state >> 1) | (int)(input << (CONSTRAINT_LENGTH_K-2));
+        out_bytes[i/8] |= (uint8_t)(input << (7-(i % 8)));
+    }
+}
+
+int16_t HardDecisionViterbiDecoder::GetPathError(const int state) {
+    if (is_soft) {
+        return trellis->GetPathError(state);
+    }
+    return (int16_t)(base_error + node_errors[curr_node*TOTAL_STATES + (state & (TOTAL_STATES-1))]);
+}
\ No newline at end of file
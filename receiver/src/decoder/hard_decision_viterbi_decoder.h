@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include "utility/span.h"
+#include "viterbi_config.h"
+
+#define CODE_RATE 2
+
+template <int K, int R> class ViterbiTrellis;
+
+// Viterbi decoder for hard decision bits of the K=3 rate 1/2 code
+// With hard decisions the path errors relative to the best state can only take a few values
+// Each of these normalised path errors is a node in a small state machine
+// One lookup per encoded byte performs 4 trellis steps and gives their 16 decision bits
+// Soft decision bits fall back to the generic add compare select until the next reset
+// NOTE: Gives the same decoded bits and path errors as ViterbiDecoder
+//       This includes the initial path errors and the renormalisation when the errors get too large
+class HardDecisionViterbiDecoder
+{
+public:
+    static constexpr int CONSTRAINT_LENGTH_K = 3;
+    static constexpr int TOTAL_STATES = 1 << (CONSTRAINT_LENGTH_K-1);
+private:
+    using Trellis = ViterbiTrellis<CONSTRAINT_LENGTH_K, CODE_RATE>;
+    const int max_steps;
+    // node_errors[node*TOTAL_STATES + state] = path error relative to the best state
+    std::vector<int16_t> node_errors;
+    int16_t max_node_error;
+    int start_node;
+    // step_table[node*4 + 2bit symbol] and byte_table[node*256 + 8bit byte] are packed as
+    // [0:7] = next node, [8:15] = increase of the best path error, [16:31] = decision bits
+    std::vector<uint32_t> step_table;
+    std::vector<uint32_t> byte_table;
+    // path error of each state is base_error + node_errors[curr_node*TOTAL_STATES + state]
+    int curr_node;
+    int base_error;
+    // falls back to the full trellis once soft decision bits are used
+    std::unique_ptr<Trellis> trellis;
+    bool is_soft = false;
+    std::vector<int16_t> soft_bits;
+    // decisions[step/4] has the 4 decision bits for that step at bit 4*(step % 4)
+    std::vector<uint16_t> decisions;
+    int curr_step = 0;
+public:
+    // _input_bits = maximum number of decoded bits until the decoder is reset
+    HardDecisionViterbiDecoder(const uint8_t poly[CODE_RATE], const int _input_bits);
+    ~HardDecisionViterbiDecoder();
+    HardDecisionViterbiDecoder(HardDecisionViterbiDecoder&) = delete;
+    HardDecisionViterbiDecoder(HardDecisionViterbiDecoder&&) = delete;
+    HardDecisionViterbiDecoder& operator=(HardDecisionViterbiDecoder&) = delete;
+    HardDecisionViterbiDecoder& operator=(HardDecisionViterbiDecoder&&) = delete;
+    void Reset();
+    // Hard decision bits packed msb first
+    void Update(tcb::span<const uint8_t> encoded_bytes);
+    // Soft decision bits, refer to viterbi_config.h for the range
+    void UpdateSoft(tcb::span<const viterbi_bit_t> encoded_bits);
+    void GetTraceback(tcb::span<uint8_t> out_bytes, const int end_state=0);
+    int16_t GetPathError(const int state=0);
+private:
+    void CreateTables(const uint8_t poly[CODE_RATE]);
+    void UpdateStep(const int symbol);
+    void SwitchToSoft();
+};
\ No newline at end of file
@@ -1,46 +1,105 @@
 #include "preamble_detector.h"
+#include <assert.h>
 
-PreambleDetector::PreambleDetector(const int32_t _preamble, const int _total_phases) 
-: total_phases(_total_phases) {
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "dsp/simd/simd_config.h"
+
+PreambleDetector::PreambleDetector(const uint32_t _preamble, const int _total_phases, ConstellationSpecification& _constellation) 
+: constellation(_constellation), 
+  preamble(_preamble), 
+  total_phases(_total_phases),
+  bits_per_symbol(_constellation.GetBitsPerSymbol()) 
+{
+    assert(total_phases <= MAX_PHASES);
     const float PI = 3.1415f;
 
-    preamble_filters.reserve(total_phases);
     preamble_phases.resize(total_phases);
-
     for (int i = 0; i < total_phases; i++) {
-        auto filter = std::make_unique<VariablePreambleFilter<uint32_t>>(_preamble);
-        preamble_filters.push_back(std::move(filter));
         // phase = k*2*PI/M
         const float phase = 2.0f*PI/(float)(total_phases) * (float)(i);
         preamble_phases[i] = std::complex<float>(std::cos(phase), std::sin(phase));
     }
+
+    // Find which symbol each constellation point lands on after being rotated
+    const int N = 1 << bits_per_symbol;
+    const int M = constellation.GetSize();
+    const auto* points = constellation.GetSymbols();
+    symbol_rotations.resize(total_phases*N, 0);
+    packed_rotations.resize(N*MAX_PHASES, 0);
+    for (int i = 0; i < M; i++) {
+        const uint8_t sym = constellation.GetNearestSymbol(points[i]);
+        for (int phase = 0; phase < total_phases; phase++) {
+            const uint8_t sym_rot = constellation.GetNearestSymbol(points[i] * preamble_phases[phase]);
+            symbol_rotations[phase*N + sym] = sym_rot;
+            packed_rotations[sym*MAX_PHASES + phase] = sym_rot;
+        }
+    }
+
+    Reset();
+}
+
+bool PreambleDetector::Process(const std::complex<float> IQ) {
+    return ProcessSymbol(constellation.GetNearestSymbol(IQ));
 }
 
-bool PreambleDetector::Process(const std::complex<float> IQ, ConstellationSpecification& constellation) 
+bool PreambleDetector::ProcessSymbol(const uint8_t sym) 
 {
-    const int bits_per_symbol = constellation.GetBitsPerSymbol();
     bits_since_preamble += bits_per_symbol;
 
+    const uint32_t found_mask = UpdateRegisters(sym);
+    if (found_mask == 0) {
+        return false;
+    }
+
     int total_preambles_found = 0;
     for (int i = 0; i < total_phases; i++) {
-        auto& filter = preamble_filters[i];
-        auto IQ_phi = IQ * preamble_phases[i];
-        auto sym = constellation.GetNearestSymbol(IQ_phi);
-        const bool res = filter->process(sym, bits_per_symbol);
-        if (!res) {
-            continue;
+        if (found_mask & (1u << i)) {
+            selected_phase = i;
+            total_preambles_found += 1;
         }
-
-        selected_phase = i;
-        total_preambles_found += 1;
-        desync_bitcount = bits_since_preamble - filter->get_length();
     }
 
-    if (total_preambles_found > 0) {
-        phase_conflict = (total_preambles_found > 1);
-        bits_since_preamble = 0;
-        return true;
+    constexpr int preamble_length = (int)sizeof(preamble)*8;
+    desync_bitcount = bits_since_preamble - preamble_length;
+    phase_conflict = (total_preambles_found > 1);
+    bits_since_preamble = 0;
+    return true;
+}
+
+#if defined(_DSP_SSSE3)
+uint32_t PreambleDetector::UpdateRegisters(const uint8_t sym) {
+    // All 4 registers are shifted and compared as one 128bit value
+    const __m128i shift = _mm_cvtsi32_si128(bits_per_symbol);
+    const __m128i rot = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&packed_rotations[sym*MAX_PHASES]));
+    __m128i regs = _mm_load_si128(reinterpret_cast<const __m128i*>(preamble_regs));
+    regs = _mm_or_si128(_mm_sll_epi32(regs, shift), rot);
+    _mm_store_si128(reinterpret_cast<__m128i*>(preamble_regs), regs);
+
+    const __m128i match = _mm_cmpeq_epi32(regs, _mm_set1_epi32((int)preamble));
+    const uint32_t phase_mask = (1u << total_phases) - 1u;
+    return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(match)) & phase_mask;
+}
+#else
+uint32_t PreambleDetector::UpdateRegisters(const uint8_t sym) {
+    uint32_t found_mask = 0;
+    for (int i = 0; i < total_phases; i++) {
+        auto& reg = preamble_regs[i];
+        reg = (reg << bits_per_symbol) | packed_rotations[sym*MAX_PHASES + i];
+        found_mask |= (uint32_t)(reg == preamble) << i;
     }
+    return found_mask;
+}
+#endif
+
+tcb::span<const uint8_t> PreambleDetector::GetSymbolRotation(const int phase_index) {
+    const int N = 1 << bits_per_symbol;
+    return { &symbol_rotations[phase_index*N], (size_t)N };
+}
 
-    return false;
-}
\ No newline at end of file
+void PreambleDetector::Reset() {
+    for (int i = 0; i < MAX_PHASES; i++) {
+        preamble_regs[i] = 0;
+    }
+    bits_since_preamble = 0;
+}
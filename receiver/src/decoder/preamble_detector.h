@@ -1,10 +1,10 @@
 #pragma once
+#include <stdint.h>
 #include <complex>
 #include <vector>
-#include <memory>
 
-#include "preamble_filter.h"
 #include "constellation/constellation.h"
+#include "utility/span.h"
 
 // Consists of a bank of:
 // 1. preamble filters
@@ -13,20 +13,44 @@
 // There are multiple potential locked phases for a M-PSK or a QAM signal
 // For M-PSK there are M possible phases: k*2*PI/M where k=[1,M]
 // For M-QAM there are 4 possible phases: 0, PI/2, PI, -PI/2
+// NOTE: A constellation with rotational symmetry maps a rotated symbol onto another symbol
+//       Instead of rotating and slicing the IQ sample for each phase we slice once 
+//       and use a lookup table to get the symbol for each phase
+//       The shift registers for each phase are packed together and compared in one go
 class PreambleDetector {
+public:
+    static constexpr int MAX_PHASES = 4;
 private:
-    std::vector<std::unique_ptr<PreambleFilter>> preamble_filters;
+    ConstellationSpecification& constellation;
+    const uint32_t preamble;
+    const int total_phases;
+    const int bits_per_symbol;
     std::vector<std::complex<float>> preamble_phases;
+    // symbol_rotations[phase*N + sym] = symbol after rotating by phase
+    std::vector<uint8_t> symbol_rotations;
+    // packed_rotations[sym*MAX_PHASES + phase] = symbol after rotating by phase
+    // Layout matches the packed shift registers so all phases can be updated together
+    std::vector<uint32_t> packed_rotations;
+    // shift register for each phase
+    alignas(16) uint32_t preamble_regs[MAX_PHASES];
     int bits_since_preamble = 0;
-    const int total_phases;
     int selected_phase = 0;
     bool phase_conflict = false;
     int desync_bitcount = 0;
 public:
-    PreambleDetector(const int32_t _preamble, const int _total_phases);
-    bool Process(const std::complex<float> IQ, ConstellationSpecification& constellation);
+    PreambleDetector(const uint32_t _preamble, const int _total_phases, ConstellationSpecification& _constellation);
+    bool Process(const std::complex<float> IQ);
+    // sym = symbol that was sliced without any phase correction
+    bool ProcessSymbol(const uint8_t sym);
     bool IsPhaseConflict() { return phase_conflict; }
     std::complex<float> GetPhase() { return preamble_phases[selected_phase]; }
     int GetPhaseIndex() { return selected_phase; }
     int GetDesyncBitcount() { return desync_bitcount; }
-};
\ No newline at end of file
+    int GetTotalPhases() { return total_phases; }
+    // Lookup table for a symbol after being rotated by the phase
+    tcb::span<const uint8_t> GetSymbolRotation(const int phase_index);
+    void Reset();
+private:
+    // return bit mask of which phases contain the preamble
+    uint32_t UpdateRegisters(const uint8_t sym);
+};
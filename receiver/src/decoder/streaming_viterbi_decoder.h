@@ -0,0 +1,148 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+#include "generic_viterbi_decoder.h"
+
+// Viterbi decoder which emits decoded bytes continuously instead of at the end of the frame
+// Only a sliding window of decisions is kept so memory and latency do not depend on the frame length
+// Each block of output bits is traced back from the best state at the newest step
+// The traceback runs through traceback_depth extra steps first so the survivor paths have merged
+// Refer to ViterbiTrellis for the conventions used
+template <int K, int R>
+class StreamingViterbiDecoder
+{
+public:
+    using Trellis = ViterbiTrellis<K,R>;
+    static constexpr int TOTAL_STATES = Trellis::TOTAL_STATES;
+    static constexpr int DECISION_WORDS = Trellis::DECISION_WORDS;
+private:
+    const int traceback_depth;
+    const int output_bits;
+    Trellis trellis;
+    // decisions[(step % window_size)*DECISION_WORDS + state/32]
+    int window_size;
+    std::vector<uint32_t> decisions;
+    int16_t soft_bits[8*R];
+    int soft_bits_length = 0;
+    int curr_step = 0;
+    int emitted_bits = 0;
+public:
+    // _traceback_depth = number of steps the survivor paths are given to merge, usually 5 to 7 times K
+    // output_bytes = number of bytes emitted together for each traceback
+    StreamingViterbiDecoder(const uint16_t poly[R], const int _traceback_depth, const int output_bytes=1)
+    : traceback_depth(_traceback_depth),
+      output_bits(output_bytes*8),
+      trellis(poly)
+    {
+        assert(traceback_depth >= 0);
+        assert(output_bytes > 0);
+        // decisions are needed from the oldest undecoded bit up to the newest step
+        window_size = 1;
+        while (window_size < (traceback_depth + output_bits + K)) {
+            window_size = window_size << 1;
+        }
+        decisions.resize(window_size*DECISION_WORDS);
+        Reset();
+    }
+    StreamingViterbiDecoder(StreamingViterbiDecoder&) = delete;
+    StreamingViterbiDecoder(StreamingViterbiDecoder&&) = delete;
+    StreamingViterbiDecoder& operator=(StreamingViterbiDecoder&) = delete;
+    StreamingViterbiDecoder& operator=(StreamingViterbiDecoder&&) = delete;
+
+    void Reset(const int starting_state=0) {
+        trellis.Reset(starting_state);
+        soft_bits_length = 0;
+        curr_step = 0;
+        emitted_bits = 0;
+    }
+
+    // Hard decision bits packed msb first
+    // Returns the number of decoded bytes written to out_bytes
+    // NOTE: out_bytes must fit all the bytes that can be emitted
+    //       This is at most the number of encoded bits divided by R rounded up to whole bytes
+    int Update(tcb::span<const uint8_t> encoded_bytes, tcb::span<uint8_t> out_bytes) {
+        int nb_out_bytes = 0;
+        for (const uint8_t x: encoded_bytes) {
+            for (int i = 0; i < 8; i++) {
+                const bool v = (x & (1 << (7-i))) != 0;
+                soft_bits[soft_bits_length++] = v ? SOFT_DECISION_VITERBI_HIGH : SOFT_DECISION_VITERBI_LOW;
+            }
+            const int nb_steps = soft_bits_length/R;
+            for (int s = 0; s < nb_steps; s++) {
+                nb_out_bytes += update_step(&soft_bits[s*R], out_bytes.data() + nb_out_bytes);
+            }
+            // keep the bits of an incomplete step for the next byte
+            const int nb_remain = soft_bits_length - nb_steps*R;
+            for (int i = 0; i < nb_remain; i++) {
+                soft_bits[i] = soft_bits[nb_steps*R + i];
+            }
+            soft_bits_length = nb_remain;
+        }
+        return nb_out_bytes;
+    }
+
+    // Emit the remaining bits up to the newest step using a known end state
+    // The traceback starts from end_state at the newest step
+    // The last K-1 bits have no decisions yet and are read from end_state, oldest bit in the msb
+    // Bits past the newest step which pad out the last byte are zero
+    // Returns the number of decoded bytes written to out_bytes
+    int Flush(tcb::span<uint8_t> out_bytes, const int end_state=0) {
+        const int nb_bits = curr_step - emitted_bits;
+        const int nb_bytes = (nb_bits+7)/8;
+        if (nb_bytes <= 0) {
+            return 0;
+        }
+        const int last_state = end_state & (TOTAL_STATES-1);
+        traceback(last_state, curr_step-1, nb_bytes*8, out_bytes.data());
+        for (int j = 0; j < (K-1); j++) {
+            const int i = curr_step + j - (emitted_bits + (K-1));
+            if (i < 0) {
+                continue;
+            }
+            const uint32_t input = (uint32_t)(last_state >> (K-2-j)) & 0b1;
+            out_bytes[i/8] |= (uint8_t)(input << (7-(i % 8)));
+        }
+        emitted_bits += nb_bytes*8;
+        return nb_bytes;
+    }
+
+    int16_t GetPathError(const int state=0) const {
+        return trellis.GetPathError(state);
+    }
+    int GetTracebackDepth() const { return traceback_depth; }
+private:
+    int update_step(const int16_t* syms, uint8_t* out_bytes) {
+        trellis.Update(syms, &decisions[(curr_step & (window_size-1))*DECISION_WORDS]);
+        curr_step++;
+
+        // bit i depends on the decision at step i+K-1
+        const int last_step = emitted_bits + output_bits + (K-1) + traceback_depth;
+        if (curr_step < last_step) {
+            return 0;
+        }
+        traceback(trellis.GetBestState(), curr_step-1, output_bits, out_bytes);
+        emitted_bits += output_bits;
+        return output_bits/8;
+    }
+
+    // Chain back from start_step and keep the oldest nb_out_bits bits starting from emitted_bits
+    void traceback(int curr_state, const int start_step, const int nb_out_bits, uint8_t* out_bytes) {
+        for (int i = 0; i < nb_out_bits/8; i++) {
+            out_bytes[i] = 0x00;
+        }
+
+        const int first_step = emitted_bits + (K-1);
+        for (int step = start_step; step >= first_step; step--) {
+            const uint32_t* d = &decisions[(step & (window_size-1))*DECISION_WORDS];
+            const uint32_t input = (d[curr_state/32] >> (curr_state % 32)) & 0b1;
+            curr_state = (curr_state >> 1) | (int)(input << (K-2));
+            const int i = step - first_step;
+            if (i < nb_out_bits) {
+                out_bytes[i/8] |= (uint8_t)(input << (7-(i % 8)));
+            }
+        }
+    }
+};
@@ -6,6 +6,7 @@
 constexpr float PI = (float)M_PI;
 
 PLL_mixer::PLL_mixer() {
+    oscillator = PLL_Oscillator::LUT_INTERPOLATE;
     phase_error = 0.0f;
     phase_error_gain = 4.0f/PI;
     fcenter = 0e3;
@@ -16,6 +17,17 @@ std::complex<float> PLL_mixer::update(void) {
     float control = phase_error * phase_error_gain;
     control = dsp::clamp(control, -1.0f, 1.0f);
     float freq = fcenter + control*fgain;
+
+    switch (oscillator) {
+    case PLL_Oscillator::LUT:
+        return nco.update<false>(freq*integrator.KTs);
+    case PLL_Oscillator::LUT_INTERPOLATE:
+        return nco.update<true>(freq*integrator.KTs);
+    case PLL_Oscillator::STD_MATH:
+    default:
+        break;
+    }
+
     float t = integrator.process(2.0f*PI*freq);
     t = std::fmod(t, 2.0f*PI);
     integrator.yn = t;
@@ -2,12 +2,22 @@
 
 #include <complex>
 #include "dsp/integrator.h"
+#include "dsp/nco.h"
+
+// Oscillator used to generate the mixer output
+enum class PLL_Oscillator {
+    STD_MATH,               // fmod + std::cos + std::sin
+    LUT,                    // fixed point phase + nearest entry in quarter wave table
+    LUT_INTERPOLATE,        // fixed point phase + linear interpolated quarter wave table
+};
 
 // phase locked loop mixer for carrier
 class PLL_mixer 
 {
 public:
-    Integrator_Block<float> integrator;
+    Integrator_Block<float> integrator; // KTs is the sampling period 
+    NCO nco;
+    PLL_Oscillator oscillator;
     float phase_error;
     float phase_error_gain;
     float fcenter;
@@ -15,4 +25,4 @@ public:
 public:
     PLL_mixer();
     std::complex<float> update(void);
-};
\ No newline at end of file
+};
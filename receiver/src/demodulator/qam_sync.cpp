@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <assert.h>
+#include <algorithm>
 
 #include "qam_sync.h"
 #include "dsp/filter_designer.h"
@@ -11,6 +12,10 @@ constexpr float PI = (float)M_PI;
 constexpr float N_levels[4] = {0.5f, 0.0f, -0.5f, -1.0f};
 constexpr int total_levels = 4;
 
+// Downsampled samples processed by every front end stage before moving onto the next tile
+// This keeps the raw input and filtered output of a tile within the L1 cache
+constexpr int FRONT_END_TILE_SIZE = 1024;
+
 QAM_Synchroniser::QAM_Synchroniser(
     QAM_Synchroniser_Specification _spec,
     ConstellationSpecification& _constellation)
@@ -36,7 +41,7 @@ QAM_Synchroniser::QAM_Synchroniser(
     {
         auto& s = spec.downsampling_filter;
         const float k = Fsymbol/(Fsource/2.0f);
-        filter_ds = std::make_unique<PolyphaseDownsampler<std::complex<float>>>(s.M, s.K);
+        filter_ds = std::make_unique<PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>>(s.M, s.K);
         create_fir_lpf(filter_ds->get_b(), filter_ds->get_K(), k);
     } 
 
@@ -63,6 +68,7 @@ QAM_Synchroniser::QAM_Synchroniser(
         pll.mixer.fcenter = s.f_center;
         pll.mixer.fgain = -s.f_gain;
         pll.mixer.phase_error_gain = s.phase_error_gain;
+        pll.mixer.oscillator = s.oscillator;
     }
 
     // carrier pll loop filter
@@ -88,6 +94,7 @@ QAM_Synchroniser::QAM_Synchroniser(
         auto b = std::vector<float>(NN);
         create_fir_lpf(b.data(), NN, k);
         filter_us = std::make_unique<PolyphaseUpsampler<std::complex<float>>>(b.data(), s.L, s.K);
+        x_upsampled_block = AlignedVector<std::complex<float>>(s.L);
     } else {
         filter_us = NULL;
     }
@@ -120,36 +127,58 @@ QAM_Synchroniser::QAM_Synchroniser(
 }
 
 int QAM_Synchroniser::ProcessBlock(QAM_Synchroniser_Buffer& buffers)
+{
+    ProcessFrontEnd(buffers);
+    return ProcessSync(buffers);
+}
+
+void QAM_Synchroniser::ProcessFrontEnd(QAM_Synchroniser_Buffer& buffers)
+{
+    const int ds_size = buffers.GetPLLSize();
+    const int M = buffers.GetDownsamplingFactor();
+    const bool is_diagnostics = buffers.IsDiagnostics();
+
+    // per block filtering is done in tiles
+    // raw IQ is converted to floats inside the downsampling filter
+    // without diagnostics the ac filter is applied inplace on x_ac
+    // the agc only measures the power of each tile and its gain is applied when x_ac is read
+    for (int i = 0; i < ds_size; i += FRONT_END_TILE_SIZE) {
+        const int N = std::min(FRONT_END_TILE_SIZE, ds_size-i);
+        auto* x_ac = &buffers.x_ac[i];
+        auto* x_downsampled = is_diagnostics ? &buffers.x_downsampled[i] : x_ac;
+        filter_ds->process(&buffers.x_raw[i*M], x_downsampled, N);
+        filter_ac->process(x_downsampled, x_ac, N);
+        filter_agc.measure_tile(x_ac, N);
+    }
+    buffers.agc_gain = filter_agc.update_block();
+}
+
+int QAM_Synchroniser::ProcessSync(QAM_Synchroniser_Buffer& buffers)
+{
+    if (buffers.IsDiagnostics()) {
+        return ProcessSync<true>(buffers);
+    }
+    return ProcessSync<false>(buffers);
+}
+
+template <bool is_diagnostics>
+int QAM_Synchroniser::ProcessSync(QAM_Synchroniser_Buffer& buffers)
 {
     float thresh_acquire_error = 0.2f; // max distance allowed for a valid symbol reading
     const bool use_all_points = false;
 
-    const int source_size = buffers.GetInputSize();
     const int ds_size = buffers.GetPLLSize();
     const int us_size = buffers.GetTEDSize();
     const int L = us_size/ds_size;
 
+    const float agc_gain = buffers.agc_gain;
     int total_symbols = 0;
 
-    for (int i = 0; i < source_size; i++) {
-        const auto& IQ = buffers.x_raw[i];
-        const float I = static_cast<float>(IQ.real()) - 128.0f;
-        const float Q = static_cast<float>(IQ.imag()) - 128.0f;
-        buffers.x_in[i] = std::complex<float>(I, Q);
-    }
-
-    // per block filtering
-    {
-        filter_ds->process(buffers.x_in.data(), buffers.x_downsampled.data(), ds_size);
-        filter_ac->process(buffers.x_downsampled.data(), buffers.x_ac.data(), ds_size);
-        filter_agc.process(buffers.x_ac.data(), buffers.x_agc.data(), ds_size);
-    }
-
     // Our multirate processing loop
     // Outer loop runs at Fdownsample
     // Inner TED loop runs at Fupsample
     for (int i = 0; i < ds_size; i++) {
-        const auto IQ_raw = buffers.x_agc[i];
+        const auto IQ_raw = agc_gain * buffers.x_ac[i];
         const auto IQ_mixer_out = pll.mixer.update();
         const auto IQ_pll = IQ_raw * IQ_mixer_out;
 
@@ -171,20 +200,24 @@ int QAM_Synchroniser::ProcessBlock(QAM_Synchroniser_Buffer& buffers)
             pll.mixer.phase_error = error_lpf + pll.int_error.yn;
         }
 
-        buffers.x_pll_out[i] = IQ_pll;
-        buffers.error_pll[i] = pll.mixer.phase_error;
+        if constexpr(is_diagnostics) {
+            buffers.x_pll_out[i] = IQ_pll;
+            buffers.error_pll[i] = pll.mixer.phase_error;
+        }
 
         // Upsample signal (optional)
-        auto rd_buf = buffers.x_pll_out;
+        // Without diagnostics the upsampled block is kept in a scratch buffer
+        const std::complex<float>* rd_buf = &IQ_pll;
         if (filter_us) {
-            filter_us->process(&buffers.x_pll_out[i], &buffers.x_upsampled[i*L], 1);
-            rd_buf = buffers.x_upsampled;
+            auto* wr_buf = is_diagnostics ? &buffers.x_upsampled[i*L] : x_upsampled_block.data();
+            filter_us->process_sample(IQ_pll, wr_buf);
+            rd_buf = wr_buf;
         }
 
         for (int j = 0; j < L; j++) {
             const int us_i = i*L + j;
 
-            const auto IQ_us_pll = rd_buf[us_i];
+            const auto IQ_us_pll = rd_buf[j];
             bool is_zero_crossing = false;
             {
                 is_zero_crossing = I_zcd->process(IQ_us_pll.real()) || is_zero_crossing;
@@ -222,13 +255,15 @@ int QAM_Synchroniser::ProcessBlock(QAM_Synchroniser_Buffer& buffers)
                 pll.prev_error = res.phase_error;
             } 
 
-            buffers.trig_zero_crossing[us_i] = is_zero_crossing;
-            buffers.trig_ted_clock[us_i] = is_ted_clock_trigger;
-            buffers.trig_integrator_dump[us_i] = is_integrate_dump_trigger;
-            
-            // place all of our data into the buffer
-            buffers.error_ted[us_i] = ted.clock.phase_error;
-            buffers.y_sym_out[us_i] = y_sym_out;
+            if constexpr(is_diagnostics) {
+                buffers.trig_zero_crossing[us_i] = is_zero_crossing;
+                buffers.trig_ted_clock[us_i] = is_ted_clock_trigger;
+                buffers.trig_integrator_dump[us_i] = is_integrate_dump_trigger;
+                
+                // place all of our data into the buffer
+                buffers.error_ted[us_i] = ted.clock.phase_error;
+                buffers.y_sym_out[us_i] = y_sym_out;
+            }
         }
     }
 
@@ -31,10 +31,11 @@ private:
     int Nsymbol;
 private:
     // prefiltering before demodulation
-    std::unique_ptr<PolyphaseDownsampler<std::complex<float>>> filter_ds;
+    std::unique_ptr<PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>> filter_ds;
     std::unique_ptr<IIR_Filter<std::complex<float>>> filter_ac;
     AGC_Filter<std::complex<float>> filter_agc;
     std::unique_ptr<PolyphaseUpsampler<std::complex<float>>> filter_us;
+    AlignedVector<std::complex<float>> x_upsampled_block;
     // phase locked loop
     struct {
         PLL_mixer mixer;
@@ -64,4 +65,16 @@ public:
     // return the number of symbols read into the buffer
     // x must be at least block_size large
     int ProcessBlock(QAM_Synchroniser_Buffer& buffers);
+    // ProcessBlock is split into two stages which touch disjoint state
+    // This lets the stages run on separate threads for consecutive blocks
+    // 1. Convert raw IQ and run per block filtering in cache sized tiles: x_raw -> x_ac, agc_gain
+    void ProcessFrontEnd(QAM_Synchroniser_Buffer& buffers);
+    // 2. Carrier and timing recovery: x_ac -> y_out
+    //    return the number of symbols read into the buffer
+    int ProcessSync(QAM_Synchroniser_Buffer& buffers);
+private:
+    // Diagnostics are selected at compile time so the symbols only loop 
+    // doesn't pay for the per sample writes into the visualisation buffers
+    template <bool is_diagnostics>
+    int ProcessSync(QAM_Synchroniser_Buffer& buffers);
 };
\ No newline at end of file
@@ -16,16 +16,19 @@ public:
     const int us_block_size;                     // L/M * Fs
     const int ds_factor;
     const int us_factor;
+    // If false then the per sample diagnostic buffers are empty and only y_out is written
+    const bool is_diagnostics;
     // Input 
     tcb::span<std::complex<uint8_t>> x_raw;       // Fs
-    tcb::span<std::complex<float>> x_in;          // Fs
     // Downsampled PLL
+    tcb::span<std::complex<float>> x_ac;          // Fs/M
+    // AGC gain of the block which is applied to x_ac when it is read
+    float agc_gain = 1.0f;
+    // Downsampled PLL diagnostics
     tcb::span<std::complex<float>> x_downsampled; // Fs/M
-    tcb::span<std::complex<float>> x_ac;          // Fs/M 
-    tcb::span<std::complex<float>> x_agc;         // Fs/M
     tcb::span<std::complex<float>> x_pll_out;     // Fs/M
     tcb::span<float> error_pll;                   // Fs/M
-    // Upsampled TED
+    // Upsampled TED diagnostics
     tcb::span<std::complex<float>> x_upsampled;   // L/M * Fs
     tcb::span<bool> trig_zero_crossing;           // L/M * Fs
     tcb::span<bool> trig_ted_clock;               // L/M * Fs
@@ -35,7 +38,7 @@ public:
     // Output symbols
     tcb::span<std::complex<float>> y_out;         // Fsymbol
 public:
-    QAM_Synchroniser_Buffer(const int _block_size, const int M, const int L);
+    QAM_Synchroniser_Buffer(const int _block_size, const int M, const int L, const bool _is_diagnostics=true);
     size_t Size() { return data_allocate.size(); }
     bool CopyFrom(QAM_Synchroniser_Buffer& in); 
     int GetInputSize() const { return src_block_size; }
@@ -43,4 +46,5 @@ public:
     int GetTEDSize() const { return us_block_size; }
     int GetDownsamplingFactor() const { return ds_factor; }
     int GetUpsamplingFactor() const { return us_factor; }
+    bool IsDiagnostics() const { return is_diagnostics; }
 };
\ No newline at end of file
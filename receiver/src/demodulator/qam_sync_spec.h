@@ -1,5 +1,7 @@
 #pragma once
 
+#include "pll_mixer.h"
+
 // Diagram of our carrier to symbol demodulator
 // RX_IN --> 8bit IQ --> [8bit to float] --> Downsample --> AC Filter --> AGC --> X0
 
@@ -38,6 +40,7 @@ struct QAM_Synchroniser_Specification
         float f_center = 0e3;
         float f_gain = 5e3;
         float phase_error_gain = 8.0f/3.1415f;
+        PLL_Oscillator oscillator = PLL_Oscillator::LUT_INTERPOLATE;
     } carrier_pll;
 
     struct {
@@ -11,21 +11,49 @@ public:
     float beta = 0.2f;
     void process(const T* x, T* y, const int N) {
         const float avg_power = calculate_average_power(x, N);
-        const float target_gain = std::sqrt(target_power/avg_power);
-        current_gain = current_gain + beta*(target_gain - current_gain);
+        update_gain(avg_power);
         for (int i = 0; i < N; i++) {
             y[i] = current_gain*x[i];
         }
     }
+
+    // Streaming api for when a block is processed in tiles
+    // Only the power of each tile is measured so the caller applies the gain when it reads the block
+    void measure_tile(const T* x, const int N) {
+        block_power += calculate_total_power(x, N);
+        block_size += N;
+    }
+
+    // Update and return the gain for the block from its measured tiles
+    float update_block() {
+        if (block_size == 0) {
+            return current_gain;
+        }
+        update_gain(block_power / (float)block_size);
+        block_power = 0.0f;
+        block_size = 0;
+        return current_gain;
+    }
 private:
+    float block_power = 0.0f;
+    int block_size = 0;
+
+    void update_gain(const float avg_power) {
+        const float target_gain = std::sqrt(target_power/avg_power);
+        current_gain = current_gain + beta*(target_gain - current_gain);
+    }
+
     float calculate_average_power(const T* x, const int N) {
-        float avg_power = 0.0f;
+        return calculate_total_power(x, N) / (float)N;
+    }
+
+    float calculate_total_power(const T* x, const int N) {
+        float total_power = 0.0f;
         for (int i = 0; i < N; i++) {
             const float I = x[i].real();
             const float Q = x[i].imag();
-            avg_power += (I*I + Q*Q);
+            total_power += (I*I + Q*Q);
         }
-        avg_power /= (float)N;
-        return avg_power;
+        return total_power;
     }
 };
\ No newline at end of file
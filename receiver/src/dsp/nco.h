@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+// Numerically controlled oscillator
+// Phase is kept in a 32bit fixed point accumulator where 2^32 is one full cycle
+// cos/sin are read from a quarter wave sine table with N=2^LUT_BITS steps
+// Maximum error of the output phasor is bounded by the table resolution
+// - Nearest:      pi/(4N)          N=1024 => 7.7e-4
+// - Interpolated: (pi/(2N))^2/8    N=1024 => 2.9e-7
+class NCO
+{
+public:
+    static constexpr int LUT_BITS = 10;
+    static constexpr uint32_t LUT_SIZE = 1u << LUT_BITS;
+private:
+    // Position inside a quadrant is a 30bit fixed point value
+    static constexpr int QUADRANT_BITS = 30;
+    static constexpr uint32_t QUADRANT_SIZE = 1u << QUADRANT_BITS;
+    static constexpr int FRAC_BITS = QUADRANT_BITS-LUT_BITS;
+    static constexpr uint32_t FRAC_MASK = (1u << FRAC_BITS) - 1u;
+    // sin(0) to sin(pi/2) inclusive with an extra guard entry for interpolation
+    std::vector<float> lut;
+public:
+    uint32_t phase = 0;
+public:
+    NCO() {
+        const double PI = 3.14159265358979323846;
+        lut.resize(LUT_SIZE+2);
+        for (uint32_t i = 0; i < LUT_SIZE+2; i++) {
+            const double x = (double)i / (double)LUT_SIZE * PI/2.0;
+            lut[i] = (float)std::sin(x);
+        }
+    }
+
+    // dphase = phase increment in cycles per sample
+    // return the oscillator output after advancing the phase
+    template <bool is_interpolate=true>
+    std::complex<float> update(const float dphase) {
+        constexpr float CYCLE_SCALE = 4294967296.0f;
+        phase += static_cast<uint32_t>(static_cast<int64_t>(dphase * CYCLE_SCALE));
+        return get_output<is_interpolate>();
+    }
+
+    template <bool is_interpolate=true>
+    std::complex<float> get_output() const {
+        const uint32_t quadrant = phase >> QUADRANT_BITS;
+        const uint32_t pos = phase & (QUADRANT_SIZE-1u);
+        // sin(pi/2 - x) = cos(x)
+        const float s = lookup<is_interpolate>(pos);
+        const float c = lookup<is_interpolate>(QUADRANT_SIZE-pos);
+        switch (quadrant) {
+        case 0:  return {  c,  s };
+        case 1:  return { -s,  c };
+        case 2:  return { -c, -s };
+        default: return {  s, -c };
+        }
+    }
+
+    float get_phase_radians() const {
+        const float PI = 3.14159265358979323846f;
+        return (float)phase * (2.0f*PI / 4294967296.0f);
+    }
+private:
+    // pos = [0, 2^30] maps to [0, pi/2]
+    template <bool is_interpolate>
+    float lookup(const uint32_t pos) const {
+        if constexpr(is_interpolate) {
+            const uint32_t i = pos >> FRAC_BITS;
+            const float frac = (float)(pos & FRAC_MASK) * (1.0f / (float)(1u << FRAC_BITS));
+            const float y0 = lut[i];
+            const float y1 = lut[i+1];
+            return y0 + frac*(y1-y0);
+        } else {
+            const uint32_t i = (pos + (1u << (FRAC_BITS-1))) >> FRAC_BITS;
+            return lut[i];
+        }
+    }
+};
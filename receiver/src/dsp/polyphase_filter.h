@@ -4,7 +4,8 @@
 #define _min(A,B) (A > B) ? B : A
 #define _max(A,B) (A > B) ? A : B
 
-template <typename T>
+// T_in = input samples which can differ from the output if they are converted while filtering
+template <typename T, typename T_in = T>
 class PolyphaseDownsampler
 {
 private:
@@ -12,7 +13,7 @@ private:
     const int K;
     const int NN;
     AlignedVector<float> b;
-    AlignedVector<T> xn;
+    AlignedVector<T_in> xn;
 public:
     float* get_b() const { return b.data(); }
     int    get_K() const { return NN; }
@@ -26,7 +27,7 @@ public:
      {
         for (int i = 0; i < NN; i++) {
             b[i] = 0;
-            xn[i] = 0;
+            xn[i] = get_zero_input();
         }
     }
 
@@ -37,7 +38,7 @@ public:
     //       b5 b4 b3 b2 b1 b0    => ...
     //          b5 b4 b3 b2 b1 b0 => y1
     // N = produce N output samples
-    void process(const T* x, T* y, const int N) {
+    void process(const T_in* x, T* y, const int N) {
         const int M0 = _min(K-1, N);
 
         // NOTE: When downsampling we don't expect x and y to be the same buffer
@@ -63,7 +64,11 @@ public:
     }
 
 private:
-    void push_values(const T* x, const int N) {
+    T_in get_zero_input() const {
+        return T_in(0);
+    }
+
+    void push_values(const T_in* x, const int N) {
         const int M = NN-N;
         for (int i = 0; i < M; i++) {
             xn[i] = xn[i+N];
@@ -73,7 +78,7 @@ private:
         }
     }
 
-    T apply_filter(const T* x) {
+    T apply_filter(const T_in* x) {
         T y;
         y = 0;
         for (int i = 0; i < NN; i++) {
@@ -91,14 +96,17 @@ private:
     const int K;
     const int NN;
     AlignedVector<float> b;
+    // History of the last K samples is stored as a double mapped circular buffer
+    // The window [xn_index, xn_index+K) is always contiguous so we never have to shift it
     AlignedVector<T> xn;
+    int xn_index;
 public:
     // b = FIR filter coefficients of length L*K
     // L = upsampling factor and total phases
     // K = number of coefficients per phase
     PolyphaseUpsampler(const float *_b, const int _L, const int _K) 
     : L(_L), K(_K), NN(_L*_K),
-      b(NN), xn(K)
+      b(NN), xn(2*_K), xn_index(0)
     {
         // TODO: Determine if we can use filter designer without repacking coefficients
         for (int phase = 0; phase < L; phase++) {
@@ -111,7 +119,7 @@ public:
             }
         }
 
-        for (int i = 0; i < K; i++) {
+        for (int i = 0; i < 2*K; i++) {
             xn[i] = 0;
         }
     }
@@ -129,11 +137,7 @@ public:
         // NOTE: When upsampling we don't expect x and y to be the same buffer
         // continue from previous block
         for (int i = 0; i < M0; i++) {
-            push_value(x[i]);
-            for (int phase = 0; phase < L; phase++) {
-                const int yi = i*L + phase;
-                y[yi] = apply_filter(xn.data(), phase);
-            }
+            process_sample(x[i], &y[i*L]);
         }
 
         // inplace math
@@ -149,21 +153,27 @@ public:
         push_values(&x[M1], N-M1);
     }
 
+    // Streaming api for when samples are produced one at a time
+    // x = single input sample
+    // y = L output samples
+    void process_sample(const T x, T* y) {
+        push_value(x);
+        const T* x_window = &xn[xn_index];
+        for (int phase = 0; phase < L; phase++) {
+            y[phase] = apply_filter(x_window, phase);
+        }
+    }
+
 private:
     void push_value(T x) {
-        for (int i = 0; i < (K-1); i++) {
-            xn[i] = xn[i+1];
-        }
-        xn[K-1] = x;
+        xn[xn_index] = x;
+        xn[xn_index+K] = x;
+        xn_index = (xn_index+1) % K;
     }
 
     void push_values(const T* x, const int N) {
-        const int M = K-N;
-        for (int i = 0; i < M; i++) {
-            xn[i] = xn[i+N];
-        }
-        for (int i = M, j = 0; i < K; i++, j++) {
-            xn[i] = x[j];
+        for (int i = 0; i < N; i++) {
+            push_value(x[i]);
         }
     }
 
@@ -193,4 +203,26 @@ inline float PolyphaseDownsampler<float>::apply_filter(const float* x) {
 template <>
 inline std::complex<float> PolyphaseDownsampler<std::complex<float>>::apply_filter(const std::complex<float>* x) {
     return c32_f32_cum_mul_auto(x, b.data(), NN);
-}
\ No newline at end of file
+}
+
+// Raw IQ samples from the receiver are filtered directly instead of converting them to a full rate float buffer
+#include "simd/cu8_f32_cum_mul.h"
+template <>
+inline std::complex<uint8_t> PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>::get_zero_input() const {
+    return std::complex<uint8_t>(128, 128);
+}
+
+template <>
+inline std::complex<float> PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>::apply_filter(const std::complex<uint8_t>* x) {
+    return cu8_f32_cum_mul_auto(x, b.data(), NN);
+}
+
+template <>
+inline float PolyphaseUpsampler<float>::apply_filter(const float* x, const int phase) {
+    return f32_cum_mul_auto(x, &b[phase*K], K);
+}
+
+template <>
+inline std::complex<float> PolyphaseUpsampler<std::complex<float>>::apply_filter(const std::complex<float>* x, const int phase) {
+    return c32_f32_cum_mul_auto(x, &b[phase*K], K);
+}
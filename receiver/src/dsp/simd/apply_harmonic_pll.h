@@ -26,24 +26,37 @@ void apply_harmonic_pll_scalar(
 // TODO: Modify code to support ARM platforms like Raspberry PI using NEON
 #include <immintrin.h>
 #include "data_packing.h"
+#include "cpu_features.h"
 #include "c32_mul.h"
 
 #if !defined(_MSC_VER)
 #pragma message("Compiling Harmonic PLL with external Intel SVML library")
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 #define SSE_MATHFUN_WITH_CODE
 #include "sse_mathfun.h"
 #define _mm_cos_ps(x) cos_ps(x)
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 #include "avx_mathfun.h"
 #define _mm256_cos_ps(x) cos256_ps(x)
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+#include "avx512_mathfun.h"
+#define _mm512_cos_ps(x) cos512_ps(x)
+DSP_TARGET_END
 #endif
 #endif
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 inline static
 void apply_harmonic_pll_ssse3(
     const float* dt, const std::complex<float>* x, std::complex<float>* y, const int N,
@@ -94,9 +107,11 @@ void apply_harmonic_pll_ssse3(
         &dt[N_vector], &x[N_vector], &y[N_vector], N_remain,
         harmonic, offset);
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 inline static 
 void apply_harmonic_pll_avx2(
     const float* dt, const std::complex<float>* x, std::complex<float>* y, const int N,
@@ -147,6 +162,55 @@ void apply_harmonic_pll_avx2(
         &dt[N_vector], &x[N_vector], &y[N_vector], N_remain,
         harmonic, offset);
 }
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+inline static 
+void apply_harmonic_pll_avx512(
+    const float* dt, const std::complex<float>* x, std::complex<float>* y, const int N,
+    const float harmonic, const float offset) 
+{
+    // 512bits = 64bytes = 8*8bytes
+    constexpr int K = 8;
+    const int M = N/K;
+
+    // Generate constants
+    const __m512 harmonic_vec = _mm512_set1_ps(harmonic);
+    cpx512_t offset_vec;
+    constexpr float PI = 3.14159265358979323846f;
+    for (int i = 0; i < K; i++) {
+        offset_vec.c32[i] = { 0.0f + offset, -PI/2.0f + offset };
+    }
+
+    // [t0 t1 ... t7] -> [t0 t0 t1 t1 ... t7 t7]
+    const __m512i PERMUTE_DUPLICATE = _mm512_set_epi32(7,7,6,6,5,5,4,4,3,3,2,2,1,1,0,0);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3 c4 c5 c6 c7]
+        // NOTE: AlignedVector is only aligned to 32 bytes so unaligned loads are used
+        __m512 b0 = _mm512_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+
+        // [t0 t0 t1 t1 ... t7 t7]
+        __m512 dt_vec = _mm512_castps256_ps512(_mm256_load_ps(&dt[i*K]));
+        dt_vec = _mm512_permutexvar_ps(PERMUTE_DUPLICATE, dt_vec);
+
+        // Apply harmonic and offset and phase split for cos+jsin
+        dt_vec = _mm512_fmadd_ps(dt_vec, harmonic_vec, offset_vec.ps);
+
+        __m512 b1 = _mm512_cos_ps(dt_vec);
+        __m512 res = c32_mul_avx512(b0, b1);
+        _mm512_storeu_ps(reinterpret_cast<float*>(&y[i*K]), res);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    apply_harmonic_pll_scalar(
+        &dt[N_vector], &x[N_vector], &y[N_vector], N_remain,
+        harmonic, offset);
+}
+DSP_TARGET_END
 #endif
 
 inline static
@@ -154,7 +218,13 @@ void apply_harmonic_pll_auto(
     const float* dt, const std::complex<float>* x, std::complex<float>* y, const int N,
     const float harmonic, const float offset) 
 {
-    #if defined(_DSP_AVX2)
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &apply_harmonic_pll_scalar, &apply_harmonic_pll_ssse3, &apply_harmonic_pll_avx2, &apply_harmonic_pll_avx512);
+    func(dt, x, y, N, harmonic, offset);
+    #elif defined(_DSP_AVX512)
+    apply_harmonic_pll_avx512(dt, x, y, N, harmonic, offset);
+    #elif defined(_DSP_AVX2)
     apply_harmonic_pll_avx2(dt, x, y, N, harmonic, offset);
     #elif defined(_DSP_SSSE3)
     apply_harmonic_pll_ssse3(dt, x, y, N, harmonic, offset);
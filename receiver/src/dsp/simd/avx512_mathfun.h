@@ -0,0 +1,99 @@
+/*
+   AVX-512F implementation of sin and cos
+   Port of "avx_mathfun.h" by Giovanni Garberoglio which is based on
+   "sse_mathfun.h" by Julien Pommier, http://gruntthepeon.free.fr/ssemath/
+   Uses the same cephes polynomials and range reduction (zlib license)
+
+   Unlike avx_mathfun.h every function is static inline so this can be
+   included in more than one translation unit
+*/
+#pragma once
+#include <immintrin.h>
+
+typedef __m512  v16sf; // vector of 16 float (avx512)
+typedef __m512i v16si; // vector of 16 int   (avx512)
+
+// Range reduction of |x| into [0,pi/4] returns the reduced value and octant j
+static inline
+v16sf avx512_mathfun_reduce(v16sf x, v16si& j) {
+    const v16sf FOPI = _mm512_set1_ps(1.27323954473516f); // 4 / M_PI
+    const v16sf MINUS_DP1 = _mm512_set1_ps(-0.78515625f);
+    const v16sf MINUS_DP2 = _mm512_set1_ps(-2.4187564849853515625e-4f);
+    const v16sf MINUS_DP3 = _mm512_set1_ps(-3.77489497744594108e-8f);
+
+    // scale by 4/Pi
+    v16sf y = _mm512_mul_ps(x, FOPI);
+    // j=(j+1) & (~1) (see the cephes sources)
+    j = _mm512_cvttps_epi32(y);
+    j = _mm512_add_epi32(j, _mm512_set1_epi32(1));
+    j = _mm512_and_si512(j, _mm512_set1_epi32(~1));
+    y = _mm512_cvtepi32_ps(j);
+
+    // The magic pass: "Extended precision modular arithmetic"
+    // x = ((x - y * DP1) - y * DP2) - y * DP3
+    x = _mm512_fmadd_ps(y, MINUS_DP1, x);
+    x = _mm512_fmadd_ps(y, MINUS_DP2, x);
+    x = _mm512_fmadd_ps(y, MINUS_DP3, x);
+    return x;
+}
+
+// Evaluate cos(x) with the first polynom and sin(x) with the second for x in [-pi/4,pi/4]
+// poly_mask selects the second polynom
+static inline
+v16sf avx512_mathfun_poly(const v16sf x, const __mmask16 poly_mask) {
+    const v16sf z = _mm512_mul_ps(x, x);
+
+    // first polynom (0 <= x <= Pi/4)
+    v16sf y = _mm512_set1_ps(2.443315711809948E-005f);
+    y = _mm512_fmadd_ps(y, z, _mm512_set1_ps(-1.388731625493765E-003f));
+    y = _mm512_fmadd_ps(y, z, _mm512_set1_ps(4.166664568298827E-002f));
+    y = _mm512_mul_ps(y, z);
+    y = _mm512_mul_ps(y, z);
+    y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+    y = _mm512_add_ps(y, _mm512_set1_ps(1.0f));
+
+    // second polynom (Pi/4 <= x <= 0)
+    v16sf y2 = _mm512_set1_ps(-1.9515295891E-4f);
+    y2 = _mm512_fmadd_ps(y2, z, _mm512_set1_ps(8.3321608736E-3f));
+    y2 = _mm512_fmadd_ps(y2, z, _mm512_set1_ps(-1.6666654611E-1f));
+    y2 = _mm512_mul_ps(y2, z);
+    y2 = _mm512_fmadd_ps(y2, x, x);
+
+    // select the correct result from the two polynoms
+    return _mm512_mask_blend_ps(poly_mask, y, y2);
+}
+
+static inline
+v16sf sin512_ps(v16sf x) { // any x
+    // sign bit of the input is kept and |x| is reduced
+    v16si sign_bit = _mm512_and_si512(_mm512_castps_si512(x), _mm512_set1_epi32((int)0x80000000));
+    v16si j;
+    x = avx512_mathfun_reduce(_mm512_abs_ps(x), j);
+
+    // get the swap sign flag
+    const v16si swap_sign = _mm512_slli_epi32(_mm512_and_si512(j, _mm512_set1_epi32(4)), 29);
+    sign_bit = _mm512_xor_si512(sign_bit, swap_sign);
+    // get the polynom selection mask
+    const __mmask16 poly_mask = _mm512_testn_epi32_mask(j, _mm512_set1_epi32(2));
+
+    const v16sf y = avx512_mathfun_poly(x, poly_mask);
+    // update the sign
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(y), sign_bit));
+}
+
+// almost the same as sin512_ps
+static inline
+v16sf cos512_ps(v16sf x) { // any x
+    v16si j;
+    x = avx512_mathfun_reduce(_mm512_abs_ps(x), j);
+    j = _mm512_sub_epi32(j, _mm512_set1_epi32(2));
+
+    // get the swap sign flag
+    const v16si sign_bit = _mm512_slli_epi32(_mm512_andnot_si512(j, _mm512_set1_epi32(4)), 29);
+    // get the polynom selection mask
+    const __mmask16 poly_mask = _mm512_testn_epi32_mask(j, _mm512_set1_epi32(2));
+
+    const v16sf y = avx512_mathfun_poly(x, poly_mask);
+    // update the sign
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(y), sign_bit));
+}
@@ -9,7 +9,8 @@
 // Accumulate sum packed complex float
 // NOTE: For performance we allow for modification of the input vector
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 static inline 
 std::complex<float> c32_cum_sum_ssse3(cpx128_t& a0) {
     // [c0 c1]
@@ -20,9 +21,11 @@ std::complex<float> c32_cum_sum_ssse3(cpx128_t& a0) {
     a0.ps = _mm_add_ps(a0.ps, a1.ps);
     return a0.c32[0];
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 static inline 
 std::complex<float> c32_cum_sum_avx2(cpx256_t& v_sum) {
     cpx128_t a0, a1;
@@ -34,4 +37,17 @@ std::complex<float> c32_cum_sum_avx2(cpx256_t& v_sum) {
     a0.ps = _mm_add_ps(a0.ps, a1.ps);
     return a0.c32[0];
 }
-#endif
\ No newline at end of file
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline 
+std::complex<float> c32_cum_sum_avx512(cpx512_t& v_sum) {
+    cpx256_t a0;
+    // [c0 c1 c2 c3]
+    a0.ps = _mm256_add_ps(v_sum.m256[0], v_sum.m256[1]);
+    return c32_cum_sum_avx2(a0);
+}
+DSP_TARGET_END
+#endif
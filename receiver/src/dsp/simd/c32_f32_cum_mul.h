@@ -2,7 +2,7 @@
 #include <assert.h>
 #include <complex>
 
-// NOTE: Assumes arrays are aligned
+// NOTE: Arrays do not need to be aligned since filter windows start at arbitrary offsets
 // Multiply and accumulate vector of complex floats with vector of floats
 
 static inline
@@ -17,10 +17,12 @@ std::complex<float> c32_f32_cum_mul_scalar(const std::complex<float>* x0, const
 // TODO: Modify code to support ARM platforms like Raspberry PI using NEON
 #include <immintrin.h>
 #include "simd_config.h"
+#include "cpu_features.h"
 #include "data_packing.h"
 #include "c32_cum_sum.h"
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 static inline
 std::complex<float> c32_f32_cum_mul_ssse3(const std::complex<float>* x0, const float* x1, const int N)
 {
@@ -40,12 +42,12 @@ std::complex<float> c32_f32_cum_mul_ssse3(const std::complex<float>* x0, const f
 
     for (int i = 0; i < M; i++) {
         // [c0 c1]
-        __m128 a0 = _mm_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
         // [c2 c3]
-        __m128 a1 = _mm_load_ps(reinterpret_cast<const float*>(&x0[i*K + K/2]));
+        __m128 a1 = _mm_loadu_ps(reinterpret_cast<const float*>(&x0[i*K + K/2]));
 
         // [a0 a1 a2 a3]
-        __m128 b0 = _mm_load_ps(&x1[i*K]);
+        __m128 b0 = _mm_loadu_ps(&x1[i*K]);
         // [a2 a2 a3 a3]
         __m128 b1 = _mm_shuffle_ps(b0, b0, PERMUTE_UPPER);
         // [a0 a0 a1 a1]
@@ -69,9 +71,11 @@ std::complex<float> c32_f32_cum_mul_ssse3(const std::complex<float>* x0, const f
 
     return y;
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 static inline
 std::complex<float> c32_f32_cum_mul_avx2(const std::complex<float>* x0, const float* x1, const int N)
 {
@@ -91,10 +95,10 @@ std::complex<float> c32_f32_cum_mul_avx2(const std::complex<float>* x0, const fl
 
     for (int i = 0; i < M; i++) {
         // [c0 c1 c2 c3]
-        __m256 a0 = _mm256_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
 
         // [a0 a1 a2 a3]
-        __m128 b0 = _mm_load_ps(&x1[i*K]);
+        __m128 b0 = _mm_loadu_ps(&x1[i*K]);
         // [a2 a2 a3 a3]
         __m128 b1 = _mm_permute_ps(b0, PERMUTE_LOWER);
         // [a0 a0 a1 a1]
@@ -104,7 +108,7 @@ std::complex<float> c32_f32_cum_mul_avx2(const std::complex<float>* x0, const fl
         __m256 a1 = _mm256_set_m128(b0, b1);
 
         // multiply accumulate
-        #if !defined(_DSP_FMA)
+        #if !defined(_DSP_AVX2_FMA)
         v_sum.ps = _mm256_add_ps(_mm256_mul_ps(a0, a1), v_sum.ps);
         #else
         v_sum.ps = _mm256_fmadd_ps(a0, a1, v_sum.ps);
@@ -119,11 +123,60 @@ std::complex<float> c32_f32_cum_mul_avx2(const std::complex<float>* x0, const fl
 
     return y;
 }
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline
+std::complex<float> c32_f32_cum_mul_avx512(const std::complex<float>* x0, const float* x1, const int N)
+{
+    // 512bits = 64bytes = 8*8bytes
+    constexpr int K = 8;
+    const int M = N/K;
+
+    // [a0 a1 ... a7] -> [a0 a0 a1 a1 ... a7 a7]
+    const __m512i PERMUTE_DUPLICATE = _mm512_set_epi32(7,7,6,6,5,5,4,4,3,3,2,2,1,1,0,0);
+
+    cpx512_t v_sum;
+    v_sum.ps = _mm512_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3 c4 c5 c6 c7]
+        __m512 a0 = _mm512_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        // [a0 a1 a2 a3 a4 a5 a6 a7]
+        __m512 a1 = _mm512_castps256_ps512(_mm256_loadu_ps(&x1[i*K]));
+        // [a0 a0 a1 a1 ... a7 a7]
+        a1 = _mm512_permutexvar_ps(PERMUTE_DUPLICATE, a1);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    // remainder is loaded with a mask since masked out elements aren't read
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    if (N_remain > 0) {
+        const __mmask16 mask_c32 = (__mmask16)((1u << (2*N_remain)) - 1u);
+        const __mmask16 mask_f32 = (__mmask16)((1u << N_remain) - 1u);
+        __m512 a0 = _mm512_maskz_loadu_ps(mask_c32, reinterpret_cast<const float*>(&x0[N_vector]));
+        __m512 a1 = _mm512_maskz_loadu_ps(mask_f32, &x1[N_vector]);
+        a1 = _mm512_permutexvar_ps(PERMUTE_DUPLICATE, a1);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    return c32_cum_sum_avx512(v_sum);
+}
+DSP_TARGET_END
 #endif
 
 inline static 
 std::complex<float> c32_f32_cum_mul_auto(const std::complex<float>* x0, const float* x1, const int N) {
-    #if defined(_DSP_AVX2)
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &c32_f32_cum_mul_scalar, &c32_f32_cum_mul_ssse3, &c32_f32_cum_mul_avx2, &c32_f32_cum_mul_avx512);
+    return func(x0, x1, N);
+    #elif defined(_DSP_AVX512)
+    return c32_f32_cum_mul_avx512(x0, x1, N);
+    #elif defined(_DSP_AVX2)
     return c32_f32_cum_mul_avx2(x0, x1, N);
     #elif defined(_DSP_SSSE3)
     return c32_f32_cum_mul_ssse3(x0, x1, N);
@@ -6,7 +6,31 @@
 
 // Multiply packed complex float 
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline
+__m512 c32_mul_avx512(__m512 x0, __m512 x1) {
+    // Vectorise complex multiplication
+    // [3 2 1 0] -> [2 3 0 1]
+    constexpr uint8_t SWAP_COMPONENT_MASK = 0b10110001;
+
+    // [d c]
+    __m512 a0 = _mm512_permute_ps(x0, SWAP_COMPONENT_MASK);
+    // [a a]
+    __m512 a1 = _mm512_moveldup_ps(x1);
+    // [b b]
+    __m512 a2 = _mm512_movehdup_ps(x1);
+    // [bd bc]
+    __m512 b0 = _mm512_mul_ps(a2, a0);
+    // [ac-bd ad+bc]
+    __m512 y = _mm512_fmaddsub_ps(a1, x0, b0);
+    return y;
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 static inline
 __m256 c32_mul_avx2(__m256 x0, __m256 x1) {
     // Vectorise complex multiplication
@@ -26,7 +50,7 @@ __m256 c32_mul_avx2(__m256 x0, __m256 x1) {
     // [bd bc]
     __m256 b0 = _mm256_mul_ps(a2, a0);
 
-    #if !defined(_DSP_FMA)
+    #if !defined(_DSP_AVX2_FMA)
     // [ac ad]
     __m256 b1 = _mm256_mul_ps(a1, x0);
     // [ac-bd ad+bc]
@@ -38,9 +62,11 @@ __m256 c32_mul_avx2(__m256 x0, __m256 x1) {
 
     return y;
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 static inline
 __m128 c32_mul_ssse3(__m128 x0, __m128 x1) {
     // Vectorise complex multiplication
@@ -72,4 +98,5 @@ __m128 c32_mul_ssse3(__m128 x0, __m128 x1) {
 
     return y;
 }
+DSP_TARGET_END
 #endif
\ No newline at end of file
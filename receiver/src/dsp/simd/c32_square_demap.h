@@ -0,0 +1,207 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+
+// Demap complex symbols onto a square constellation by quantising I and Q independently
+// Each axis has L points at (i-offset)*step where i=[0,L-1]
+// x = received symbols
+// y = gray coded symbol for each input, (gray(I) << bits_per_axis) | gray(Q)
+// mag_error = distance to the nearest point (optional, NULL to skip)
+// phase_error = arg(x*conj(nearest point)) (optional, NULL to skip)
+
+struct SquareDemapParams {
+    int L;
+    int bits_per_axis;
+    float offset;
+    float step;
+};
+
+static inline
+void c32_square_demap_scalar(
+    const std::complex<float>* x, uint8_t* y, float* mag_error, float* phase_error,
+    const int N, const SquareDemapParams& p)
+{
+    const float inv_step = 1.0f/p.step;
+    const float max_index = (float)(p.L-1);
+    for (int i = 0; i < N; i++) {
+        float fI = x[i].real()*inv_step + p.offset;
+        float fQ = x[i].imag()*inv_step + p.offset;
+        fI = (fI < 0.0f) ? 0.0f : ((fI > max_index) ? max_index : fI);
+        fQ = (fQ < 0.0f) ? 0.0f : ((fQ > max_index) ? max_index : fQ);
+        const int I = (int)(fI + 0.5f);
+        const int Q = (int)(fQ + 0.5f);
+        y[i] = (uint8_t)(((I ^ (I >> 1)) << p.bits_per_axis) | (Q ^ (Q >> 1)));
+
+        const auto ref = std::complex<float>(
+            ((float)I - p.offset)*p.step,
+            ((float)Q - p.offset)*p.step);
+        if (mag_error != NULL) {
+            mag_error[i] = std::abs(x[i]-ref);
+        }
+        if (phase_error != NULL) {
+            const auto z = x[i]*std::conj(ref);
+            phase_error[i] = std::atan2(z.imag(), z.real());
+        }
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+// atan2 approximation with a maximum error of 1e-5 radians
+// Reduce to atan(z) for z=[0,1] then fold back into the correct octant
+static inline
+__m256 f32_atan2_avx2(__m256 y, __m256 x) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 ax = _mm256_andnot_ps(sign_mask, x);
+    const __m256 ay = _mm256_andnot_ps(sign_mask, y);
+    const __m256 mx = _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_set1_ps(1e-30f));
+    const __m256 mn = _mm256_min_ps(ax, ay);
+    const __m256 a = _mm256_div_ps(mn, mx);
+    const __m256 s = _mm256_mul_ps(a, a);
+
+    __m256 r = _mm256_set1_ps(-0.01172120f);
+    #if !defined(_DSP_AVX2_FMA)
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps( 0.05265332f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(-0.11643287f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps( 0.19354346f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(-0.33262347f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps( 0.99997726f));
+    #else
+    r = _mm256_fmadd_ps(r, s, _mm256_set1_ps( 0.05265332f));
+    r = _mm256_fmadd_ps(r, s, _mm256_set1_ps(-0.11643287f));
+    r = _mm256_fmadd_ps(r, s, _mm256_set1_ps( 0.19354346f));
+    r = _mm256_fmadd_ps(r, s, _mm256_set1_ps(-0.33262347f));
+    r = _mm256_fmadd_ps(r, s, _mm256_set1_ps( 0.99997726f));
+    #endif
+    r = _mm256_mul_ps(r, a);
+
+    const float PI = 3.14159265358979323846f;
+    // |y| > |x| => pi/2 - r
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI/2.0f), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    // x < 0 => pi - r
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), x);
+    // copy sign of y
+    r = _mm256_or_ps(r, _mm256_and_ps(sign_mask, y));
+    return r;
+}
+
+static inline
+void c32_square_demap_avx2(
+    const std::complex<float>* x, uint8_t* y, float* mag_error, float* phase_error,
+    const int N, const SquareDemapParams& p)
+{
+    // 256bits = 32bytes = 4*8bytes
+    // Process 8 symbols at a time so I and Q each fill a register
+    const int K = 8;
+    const int M = N/K;
+
+    const __m256 inv_step = _mm256_set1_ps(1.0f/p.step);
+    const __m256 step = _mm256_set1_ps(p.step);
+    const __m256 offset = _mm256_set1_ps(p.offset);
+    const __m256 max_index = _mm256_set1_ps((float)(p.L-1));
+    const __m256 zero = _mm256_set1_ps(0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m128i axis_shift = _mm_cvtsi32_si128(p.bits_per_axis);
+    // Take the lowest byte of each 32bit integer in a 128bit lane
+    const __m256i pack_mask = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    for (int i = 0; i < M; i++) {
+        // [r0 i0 r1 i1 | r2 i2 r3 i3]
+        const __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        // [r4 i4 r5 i5 | r6 i6 r7 i7]
+        const __m256 a1 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K + K/2]));
+        // [r0 r1 r4 r5 | r2 r3 r6 r7] -> [r0 r1 r2 r3 | r4 r5 r6 r7]
+        __m256 xI = _mm256_shuffle_ps(a0, a1, 0b10001000);
+        __m256 xQ = _mm256_shuffle_ps(a0, a1, 0b11011101);
+        xI = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(xI), 0b11011000));
+        xQ = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(xQ), 0b11011000));
+
+        // quantise each axis
+        #if !defined(_DSP_AVX2_FMA)
+        __m256 fI = _mm256_add_ps(_mm256_mul_ps(xI, inv_step), offset);
+        __m256 fQ = _mm256_add_ps(_mm256_mul_ps(xQ, inv_step), offset);
+        #else
+        __m256 fI = _mm256_fmadd_ps(xI, inv_step, offset);
+        __m256 fQ = _mm256_fmadd_ps(xQ, inv_step, offset);
+        #endif
+        fI = _mm256_min_ps(_mm256_max_ps(fI, zero), max_index);
+        fQ = _mm256_min_ps(_mm256_max_ps(fQ, zero), max_index);
+        const __m256i iI = _mm256_cvttps_epi32(_mm256_add_ps(fI, half));
+        const __m256i iQ = _mm256_cvttps_epi32(_mm256_add_ps(fQ, half));
+
+        // gray code and combine axes into the symbol
+        const __m256i gI = _mm256_xor_si256(iI, _mm256_srli_epi32(iI, 1));
+        const __m256i gQ = _mm256_xor_si256(iQ, _mm256_srli_epi32(iQ, 1));
+        const __m256i sym = _mm256_or_si256(_mm256_sll_epi32(gI, axis_shift), gQ);
+        const __m256i sym_packed = _mm256_shuffle_epi8(sym, pack_mask);
+        const __m128i sym_bytes = _mm_unpacklo_epi32(
+            _mm256_castsi256_si128(sym_packed),
+            _mm256_extracti128_si256(sym_packed, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&y[i*K]), sym_bytes);
+
+        if ((mag_error == NULL) && (phase_error == NULL)) {
+            continue;
+        }
+
+        const __m256 rI = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(iI), offset), step);
+        const __m256 rQ = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(iQ), offset), step);
+
+        if (mag_error != NULL) {
+            const __m256 eI = _mm256_sub_ps(xI, rI);
+            const __m256 eQ = _mm256_sub_ps(xQ, rQ);
+            #if !defined(_DSP_AVX2_FMA)
+            const __m256 e2 = _mm256_add_ps(_mm256_mul_ps(eI, eI), _mm256_mul_ps(eQ, eQ));
+            #else
+            const __m256 e2 = _mm256_fmadd_ps(eI, eI, _mm256_mul_ps(eQ, eQ));
+            #endif
+            _mm256_storeu_ps(&mag_error[i*K], _mm256_sqrt_ps(e2));
+        }
+
+        if (phase_error != NULL) {
+            // x*conj(r) = (xI*rI + xQ*rQ) + j(xQ*rI - xI*rQ)
+            #if !defined(_DSP_AVX2_FMA)
+            const __m256 zI = _mm256_add_ps(_mm256_mul_ps(xI, rI), _mm256_mul_ps(xQ, rQ));
+            const __m256 zQ = _mm256_sub_ps(_mm256_mul_ps(xQ, rI), _mm256_mul_ps(xI, rQ));
+            #else
+            const __m256 zI = _mm256_fmadd_ps(xI, rI, _mm256_mul_ps(xQ, rQ));
+            const __m256 zQ = _mm256_fmsub_ps(xQ, rI, _mm256_mul_ps(xI, rQ));
+            #endif
+            _mm256_storeu_ps(&phase_error[i*K], f32_atan2_avx2(zQ, zI));
+        }
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_square_demap_scalar(
+        &x[N_vector], &y[N_vector],
+        (mag_error != NULL) ? &mag_error[N_vector] : NULL,
+        (phase_error != NULL) ? &phase_error[N_vector] : NULL,
+        N_remain, p);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+void c32_square_demap_auto(
+    const std::complex<float>* x, uint8_t* y, float* mag_error, float* phase_error,
+    const int N, const SquareDemapParams& p)
+{
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &c32_square_demap_scalar, &c32_square_demap_scalar, &c32_square_demap_avx2);
+    func(x, y, mag_error, phase_error, N, p);
+    #elif defined(_DSP_AVX2)
+    c32_square_demap_avx2(x, y, mag_error, phase_error, N, p);
+    #else
+    c32_square_demap_scalar(x, y, mag_error, phase_error, N, p);
+    #endif
+}
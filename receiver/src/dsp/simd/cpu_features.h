@@ -0,0 +1,129 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Detect which SIMD instruction sets the running cpu and operating system support
+// Used by the _auto kernels to select a variant once at startup when compiled with _DSP_DISPATCH
+// The DSP_SIMD environment variable can lower the selected level (scalar, ssse3, avx2, avx512)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+enum class DSP_SIMD_Level {
+    SCALAR = 0,
+    SSSE3 = 1,
+    AVX2 = 2,
+    AVX512 = 3,
+};
+
+inline const char* get_dsp_simd_level_string(const DSP_SIMD_Level level) {
+    switch (level) {
+    case DSP_SIMD_Level::SCALAR: return "scalar";
+    case DSP_SIMD_Level::SSSE3:  return "ssse3";
+    case DSP_SIMD_Level::AVX2:   return "avx2";
+    case DSP_SIMD_Level::AVX512: return "avx512";
+    default:                     return "unknown";
+    }
+}
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+static inline
+void dsp_cpuid(const uint32_t leaf, const uint32_t subleaf, uint32_t regs[4]) {
+    #if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (uint32_t)r[i];
+    #else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    #endif
+}
+
+// Register state the operating system saves on context switches
+static inline
+uint64_t dsp_xgetbv() {
+    #if defined(_MSC_VER)
+    return (uint64_t)_xgetbv(0);
+    #else
+    // _xgetbv() requires compiling with -mxsave so the instruction is used directly
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | (uint64_t)eax;
+    #endif
+}
+
+static inline
+DSP_SIMD_Level dsp_detect_simd_level() {
+    uint32_t regs[4];
+    dsp_cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+    if (max_leaf < 1) return DSP_SIMD_Level::SCALAR;
+
+    dsp_cpuid(1, 0, regs);
+    const uint32_t ecx_1 = regs[2];
+    const bool is_ssse3 = (ecx_1 >> 9) & 1;
+    const bool is_fma = (ecx_1 >> 12) & 1;
+    const bool is_osxsave = (ecx_1 >> 27) & 1;
+    const bool is_avx = (ecx_1 >> 28) & 1;
+    if (!is_ssse3) return DSP_SIMD_Level::SCALAR;
+    if (!is_osxsave || !is_avx || !is_fma || (max_leaf < 7)) return DSP_SIMD_Level::SSSE3;
+
+    // xmm and ymm state must be enabled by the operating system
+    const uint64_t xcr0 = dsp_xgetbv();
+    if ((xcr0 & 0x06) != 0x06) return DSP_SIMD_Level::SSSE3;
+
+    dsp_cpuid(7, 0, regs);
+    const uint32_t ebx_7 = regs[1];
+    const bool is_avx2 = (ebx_7 >> 5) & 1;
+    const bool is_avx512f = (ebx_7 >> 16) & 1;
+    if (!is_avx2) return DSP_SIMD_Level::SSSE3;
+
+    // opmask and both halves of the zmm registers must also be enabled
+    if (!is_avx512f || ((xcr0 & 0xE0) != 0xE0)) return DSP_SIMD_Level::AVX2;
+    return DSP_SIMD_Level::AVX512;
+}
+#else
+static inline
+DSP_SIMD_Level dsp_detect_simd_level() {
+    return DSP_SIMD_Level::SCALAR;
+}
+#endif
+
+static inline
+DSP_SIMD_Level dsp_read_simd_level_override(const DSP_SIMD_Level level) {
+    const char* env = getenv("DSP_SIMD");
+    if (env == NULL) return level;
+    DSP_SIMD_Level limit = level;
+    if      (strcmp(env, "scalar") == 0) limit = DSP_SIMD_Level::SCALAR;
+    else if (strcmp(env, "ssse3") == 0)  limit = DSP_SIMD_Level::SSSE3;
+    else if (strcmp(env, "avx2") == 0)   limit = DSP_SIMD_Level::AVX2;
+    else if (strcmp(env, "avx512") == 0) limit = DSP_SIMD_Level::AVX512;
+    // the override can't enable instructions the cpu doesn't have
+    return (limit < level) ? limit : level;
+}
+
+// Detected once and shared between all translation units
+inline DSP_SIMD_Level dsp_get_simd_level() {
+    static const DSP_SIMD_Level level = dsp_read_simd_level_override(dsp_detect_simd_level());
+    return level;
+}
+
+// Pick the best available variant, missing variants should be given the next lowest one
+template <typename F>
+inline F dsp_select_kernel(F scalar, F ssse3, F avx2, F avx512) {
+    switch (dsp_get_simd_level()) {
+    case DSP_SIMD_Level::AVX512: return avx512;
+    case DSP_SIMD_Level::AVX2:   return avx2;
+    case DSP_SIMD_Level::SSSE3:  return ssse3;
+    case DSP_SIMD_Level::SCALAR:
+    default:                     return scalar;
+    }
+}
+
+template <typename F>
+inline F dsp_select_kernel(F scalar, F ssse3, F avx2) {
+    return dsp_select_kernel(scalar, ssse3, avx2, avx2);
+}
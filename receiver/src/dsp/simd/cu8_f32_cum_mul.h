@@ -0,0 +1,208 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <complex>
+
+// NOTE: Arrays do not need to be aligned since filter windows start at arbitrary offsets
+// Multiply and accumulate vector of raw complex uint8 samples with vector of floats
+// Samples are offset binary so 128 is subtracted while widening them to floats in registers
+// This matches converting the samples to complex floats first and then using c32_f32_cum_mul
+
+static inline
+std::complex<float> cu8_f32_cum_mul_scalar(const std::complex<uint8_t>* x0, const float* x1, const int N) {
+    auto y = std::complex<float>(0,0);
+    for (int i = 0; i < N; i++) {
+        const float I = static_cast<float>(x0[i].real()) - 128.0f;
+        const float Q = static_cast<float>(x0[i].imag()) - 128.0f;
+        y += std::complex<float>(I, Q) * x1[i];
+    }
+    return y;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+#include "data_packing.h"
+#include "c32_cum_sum.h"
+
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static inline
+std::complex<float> cu8_f32_cum_mul_ssse3(const std::complex<uint8_t>* x0, const float* x1, const int N)
+{
+    auto y = std::complex<float>(0,0);
+
+    // 128bits = 16bytes = 4*4bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    // [3 2 1 0] -> [3 3 2 2]
+    const uint8_t PERMUTE_UPPER = 0b11111010;
+    // [3 2 1 0] -> [1 1 0 0]
+    const uint8_t PERMUTE_LOWER = 0b01010000;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi32(128);
+
+    cpx128_t v_sum;
+    v_sum.ps = _mm_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3] as 8 bytes
+        __m128i c_u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&x0[i*K]));
+        __m128i c_u16 = _mm_unpacklo_epi8(c_u8, zero);
+        // [c0 c1]
+        __m128 a0 = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(c_u16, zero), offset));
+        // [c2 c3]
+        __m128 a1 = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(c_u16, zero), offset));
+
+        // [a0 a1 a2 a3]
+        __m128 b0 = _mm_loadu_ps(&x1[i*K]);
+        // [a2 a2 a3 a3]
+        __m128 b1 = _mm_shuffle_ps(b0, b0, PERMUTE_UPPER);
+        // [a0 a0 a1 a1]
+        b0 = _mm_shuffle_ps(b0, b0, PERMUTE_LOWER);
+
+        // multiply accumulate
+        #if !defined(_DSP_FMA)
+        v_sum.ps = _mm_add_ps(_mm_mul_ps(a0, b0), v_sum.ps);
+        v_sum.ps = _mm_add_ps(_mm_mul_ps(a1, b1), v_sum.ps);
+        #else
+        v_sum.ps = _mm_fmadd_ps(a0, b0, v_sum.ps);
+        v_sum.ps = _mm_fmadd_ps(a1, b1, v_sum.ps);
+        #endif
+    }
+
+    y += c32_cum_sum_ssse3(v_sum);
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += cu8_f32_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+
+    return y;
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline
+std::complex<float> cu8_f32_cum_mul_avx2(const std::complex<uint8_t>* x0, const float* x1, const int N)
+{
+    auto y = std::complex<float>(0,0);
+
+    // 256bits = 32bytes = 4*8bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    // [3 2 1 0] -> [3 3 2 2]
+    const uint8_t PERMUTE_UPPER = 0b11111010;
+    // [3 2 1 0] -> [1 1 0 0]
+    const uint8_t PERMUTE_LOWER = 0b01010000;
+
+    const __m256i offset = _mm256_set1_epi32(128);
+
+    cpx256_t v_sum;
+    v_sum.ps = _mm256_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3] as 8 bytes widened to 8 int32
+        __m128i c_u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&x0[i*K]));
+        __m256i c_i32 = _mm256_sub_epi32(_mm256_cvtepu8_epi32(c_u8), offset);
+        // [c0 c1 c2 c3]
+        __m256 a0 = _mm256_cvtepi32_ps(c_i32);
+
+        // [a0 a1 a2 a3]
+        __m128 b0 = _mm_loadu_ps(&x1[i*K]);
+        // [a0 a0 a1 a1]
+        __m128 b1 = _mm_permute_ps(b0, PERMUTE_LOWER);
+        // [a2 a2 a3 a3]
+        b0 = _mm_permute_ps(b0, PERMUTE_UPPER);
+
+        // [a0 a0 a1 a1 a2 a2 a3 a3]
+        __m256 a1 = _mm256_set_m128(b0, b1);
+
+        // multiply accumulate
+        #if !defined(_DSP_AVX2_FMA)
+        v_sum.ps = _mm256_add_ps(_mm256_mul_ps(a0, a1), v_sum.ps);
+        #else
+        v_sum.ps = _mm256_fmadd_ps(a0, a1, v_sum.ps);
+        #endif
+    }
+
+    y += c32_cum_sum_avx2(v_sum);
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += cu8_f32_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+
+    return y;
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline
+std::complex<float> cu8_f32_cum_mul_avx512(const std::complex<uint8_t>* x0, const float* x1, const int N)
+{
+    // 512bits = 64bytes = 8*8bytes
+    constexpr int K = 8;
+    const int M = N/K;
+
+    // [a0 a1 ... a7] -> [a0 a0 a1 a1 ... a7 a7]
+    const __m512i PERMUTE_DUPLICATE = _mm512_set_epi32(7,7,6,6,5,5,4,4,3,3,2,2,1,1,0,0);
+    const __m512i offset = _mm512_set1_epi32(128);
+
+    cpx512_t v_sum;
+    v_sum.ps = _mm512_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3 c4 c5 c6 c7] as 16 bytes widened to 16 int32
+        __m128i c_u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x0[i*K]));
+        __m512 a0 = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_cvtepu8_epi32(c_u8), offset));
+        // [a0 a0 a1 a1 ... a7 a7]
+        __m512 a1 = _mm512_castps256_ps512(_mm256_loadu_ps(&x1[i*K]));
+        a1 = _mm512_permutexvar_ps(PERMUTE_DUPLICATE, a1);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    // byte masked loads need AVX512BW so the remaining samples are copied into a padded block
+    // padding of 128 is zero after the offset and the coefficients are loaded with a mask
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    if (N_remain > 0) {
+        uint8_t c_tail[2*K];
+        memset(c_tail, 128, sizeof(c_tail));
+        memcpy(c_tail, &x0[N_vector], N_remain*sizeof(std::complex<uint8_t>));
+        const __mmask16 mask_f32 = (__mmask16)((1u << N_remain) - 1u);
+        __m128i c_u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c_tail));
+        __m512 a0 = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_cvtepu8_epi32(c_u8), offset));
+        __m512 a1 = _mm512_maskz_loadu_ps(mask_f32, &x1[N_vector]);
+        a1 = _mm512_permutexvar_ps(PERMUTE_DUPLICATE, a1);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    return c32_cum_sum_avx512(v_sum);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+std::complex<float> cu8_f32_cum_mul_auto(const std::complex<uint8_t>* x0, const float* x1, const int N) {
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &cu8_f32_cum_mul_scalar, &cu8_f32_cum_mul_ssse3, &cu8_f32_cum_mul_avx2, &cu8_f32_cum_mul_avx512);
+    return func(x0, x1, N);
+    #elif defined(_DSP_AVX512)
+    return cu8_f32_cum_mul_avx512(x0, x1, N);
+    #elif defined(_DSP_AVX2)
+    return cu8_f32_cum_mul_avx2(x0, x1, N);
+    #elif defined(_DSP_SSSE3)
+    return cu8_f32_cum_mul_ssse3(x0, x1, N);
+    #else
+    return cu8_f32_cum_mul_scalar(x0, x1, N);
+    #endif
+}
@@ -10,7 +10,18 @@
 #endif
 
 // Helper unions for using floating point and integer SIMDs
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX512)
+typedef union _ALIGNED(sizeof(__m512)) cpx512_t {
+    float f32[16];
+    std::complex<float> c32[8];
+    __m256 m256[2];
+    __m512 ps;
+    __m512i i;
+    cpx512_t() {}
+} cpx512_t;
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
 typedef union _ALIGNED(sizeof(__m256)) cpx256_t {
     float f32[8];
     std::complex<float> c32[4];
@@ -21,7 +32,7 @@ typedef union _ALIGNED(sizeof(__m256)) cpx256_t {
 } cpx256_t;
 #endif
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
 typedef union _ALIGNED(sizeof(__m128)) cpx128_t {
     float f32[4];
     std::complex<float> c32[2];
@@ -1,7 +1,7 @@
 #pragma once
 #include <assert.h>
 
-// NOTE: Assumes arrays are aligned
+// NOTE: Arrays do not need to be aligned since filter windows start at arbitrary offsets
 // Multiply and accumulate vector of floats with another vector of floats
 
 static inline
@@ -16,10 +16,12 @@ float f32_cum_mul_scalar(const float* x0, const float* x1, const int N) {
 // TODO: Modify code to support ARM platforms like Raspberry PI using NEON
 #include <immintrin.h>
 #include "simd_config.h"
+#include "cpu_features.h"
 #include "data_packing.h"
 #include "f32_cum_sum.h"
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 static inline
 float f32_cum_mul_ssse3(const float* x0, const float* x1, const int N)
 {
@@ -33,8 +35,8 @@ float f32_cum_mul_ssse3(const float* x0, const float* x1, const int N)
     v_sum.ps = _mm_set1_ps(0.0f);
 
     for (int i = 0; i < M; i++) {
-        __m128 a0 = _mm_load_ps(&x0[i*K]);
-        __m128 a1 = _mm_load_ps(&x1[i*K]);
+        __m128 a0 = _mm_loadu_ps(&x0[i*K]);
+        __m128 a1 = _mm_loadu_ps(&x1[i*K]);
 
         // multiply accumulate
         #if !defined(_DSP_FMA)
@@ -52,9 +54,11 @@ float f32_cum_mul_ssse3(const float* x0, const float* x1, const int N)
 
     return y;
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 static inline
 float f32_cum_mul_avx2(const float* x0, const float* x1, const int N)
 {
@@ -68,11 +72,11 @@ float f32_cum_mul_avx2(const float* x0, const float* x1, const int N)
     v_sum.ps = _mm256_set1_ps(0.0f);
 
     for (int i = 0; i < M; i++) {
-        __m256 a0 = _mm256_load_ps(&x0[i*K]);
-        __m256 a1 = _mm256_load_ps(&x1[i*K]);
+        __m256 a0 = _mm256_loadu_ps(&x0[i*K]);
+        __m256 a1 = _mm256_loadu_ps(&x1[i*K]);
 
         // multiply accumulate
-        #if !defined(_DSP_FMA)
+        #if !defined(_DSP_AVX2_FMA)
         v_sum.ps = _mm256_add_ps(_mm256_mul_ps(a0, a1), v_sum.ps);
         #else
         v_sum.ps = _mm256_fmadd_ps(a0, a1, v_sum.ps);
@@ -87,11 +91,51 @@ float f32_cum_mul_avx2(const float* x0, const float* x1, const int N)
 
     return y;
 }
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline
+float f32_cum_mul_avx512(const float* x0, const float* x1, const int N)
+{
+    // 512bits = 64bytes = 16*4bytes
+    constexpr int K = 16;
+    const int M = N/K;
+
+    cpx512_t v_sum;
+    v_sum.ps = _mm512_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        __m512 a0 = _mm512_loadu_ps(&x0[i*K]);
+        __m512 a1 = _mm512_loadu_ps(&x1[i*K]);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    // remainder is loaded with a mask since masked out elements aren't read
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    if (N_remain > 0) {
+        const __mmask16 mask = (__mmask16)((1u << N_remain) - 1u);
+        __m512 a0 = _mm512_maskz_loadu_ps(mask, &x0[N_vector]);
+        __m512 a1 = _mm512_maskz_loadu_ps(mask, &x1[N_vector]);
+        v_sum.ps = _mm512_fmadd_ps(a0, a1, v_sum.ps);
+    }
+
+    return f32_cum_sum_avx512(v_sum);
+}
+DSP_TARGET_END
 #endif
 
 inline static 
 float f32_cum_mul_auto(const float* x0, const float* x1, const int N) {
-    #if defined(_DSP_AVX2)
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &f32_cum_mul_scalar, &f32_cum_mul_ssse3, &f32_cum_mul_avx2, &f32_cum_mul_avx512);
+    return func(x0, x1, N);
+    #elif defined(_DSP_AVX512)
+    return f32_cum_mul_avx512(x0, x1, N);
+    #elif defined(_DSP_AVX2)
     return f32_cum_mul_avx2(x0, x1, N);
     #elif defined(_DSP_SSSE3)
     return f32_cum_mul_ssse3(x0, x1, N);
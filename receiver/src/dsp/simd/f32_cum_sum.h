@@ -8,7 +8,8 @@
 // Accumulate sum packed float
 // NOTE: For performance we allow for modification of the input vector
 
-#if defined(_DSP_SSSE3)
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
 static inline 
 float f32_cum_sum_ssse3(cpx128_t& a0) {
     // [f0 f1 f2 f3]
@@ -23,9 +24,11 @@ float f32_cum_sum_ssse3(cpx128_t& a0) {
     a0.ps = _mm_add_ps(a0.ps, a1.ps);
     return a0.f32[0];
 }
+DSP_TARGET_END
 #endif
 
-#if defined(_DSP_AVX2)
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
 static inline 
 float f32_cum_sum_avx2(cpx256_t& v_sum) {
     cpx128_t a0, a1;
@@ -41,4 +44,17 @@ float f32_cum_sum_avx2(cpx256_t& v_sum) {
     a0.ps = _mm_add_ps(a0.ps, a1.ps);
     return a0.f32[0];
 }
-#endif
\ No newline at end of file
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX512)
+DSP_TARGET_AVX512_BEGIN
+static inline 
+float f32_cum_sum_avx512(cpx512_t& v_sum) {
+    cpx256_t a0;
+    // [f0 f1 f2 f3 f4 f5 f6 f7]
+    a0.ps = _mm256_add_ps(v_sum.m256[0], v_sum.m256[1]);
+    return f32_cum_sum_avx2(a0);
+}
+DSP_TARGET_END
+#endif
@@ -1,6 +1,10 @@
 #pragma once
 
 // Enable intrinsic code that can be compiled on target
+#if defined(__AVX512F__)
+#define _DSP_AVX512
+#endif
+
 #if defined(__AVX2__)
 #define _DSP_AVX2
 #endif
@@ -17,7 +21,59 @@
 #define _DSP_FMA
 #endif
 
+// On MSVC there is no define for carryless multiply but every AVX2 cpu has it
+#if defined(__PCLMUL__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define _DSP_PCLMUL
+#endif
+
+// Runtime dispatch compiles every variant and selects one for the running cpu (see cpu_features.h)
+// _DSP_AVX2 and _DSP_SSSE3 then only describe the baseline the rest of the code is compiled for
+// _DSP_BUILD_AVX512, _DSP_BUILD_AVX2 and _DSP_BUILD_SSSE3 describe which variants of the dsp/simd kernels are available
+#if defined(_DSP_DISPATCH)
+#define _DSP_BUILD_AVX512
+#define _DSP_BUILD_AVX2
+#define _DSP_BUILD_SSSE3
+#else
+#if defined(_DSP_AVX512)
+#define _DSP_BUILD_AVX512
+#endif
 #if defined(_DSP_AVX2)
+#define _DSP_BUILD_AVX2
+#endif
+#if defined(_DSP_SSSE3)
+#define _DSP_BUILD_SSSE3
+#endif
+#endif
+
+// AVX2 variants are only selected at runtime if the cpu also has FMA
+#if defined(_DSP_FMA) || defined(_DSP_DISPATCH)
+#define _DSP_AVX2_FMA
+#endif
+
+// Variants above the baseline are compiled for their instruction set by wrapping them in these
+// MSVC doesn't need this since it allows any intrinsic regardless of /arch
+#if defined(_DSP_DISPATCH) && defined(__clang__)
+#define DSP_TARGET_SSSE3_BEGIN _Pragma("clang attribute push(__attribute__((target(\"ssse3\"))), apply_to=function)")
+#define DSP_TARGET_AVX2_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx2,fma\"))), apply_to=function)")
+#define DSP_TARGET_AVX512_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma\"))), apply_to=function)")
+#define DSP_TARGET_END _Pragma("clang attribute pop")
+#elif defined(_DSP_DISPATCH) && defined(__GNUC__)
+#define DSP_TARGET_SSSE3_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"ssse3\")")
+#define DSP_TARGET_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define DSP_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+#define DSP_TARGET_END _Pragma("GCC pop_options")
+#else
+#define DSP_TARGET_SSSE3_BEGIN
+#define DSP_TARGET_AVX2_BEGIN
+#define DSP_TARGET_AVX512_BEGIN
+#define DSP_TARGET_END
+#endif
+
+#if defined(_DSP_DISPATCH)
+#pragma message("Compiling DSP SIMD with runtime dispatch of SSSE3, AVX2 and AVX512 code")
+#elif defined(_DSP_AVX512)
+#pragma message("Compiling DSP SIMD using AVX512 code")
+#elif defined(_DSP_AVX2)
 #pragma message("Compiling DSP SIMD using AVX2 code")
 #elif defined(_DSP_SSSE3)
 #pragma message("Compiling DSP SIMD using SSSE3 code")
@@ -27,4 +83,8 @@
 
 #if defined(_DSP_FMA)
 #pragma message("Compiling DSP SIMD with FMA code")
+#endif
+
+#if defined(_DSP_PCLMUL)
+#pragma message("Compiling DSP SIMD with PCLMUL code")
 #endif
\ No newline at end of file
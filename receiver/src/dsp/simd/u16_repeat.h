@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+
+// Repeat each value K times
+// y[i*K + j] = x[i] for 0 <= j < K
+// x = N values
+// y = N*K values
+
+static inline
+void u16_repeat_scalar(const uint16_t* x, uint16_t* y, const int N, const int K) {
+    for (int i = 0; i < N; i++) {
+        const uint16_t v = x[i];
+        uint16_t* out = &y[i*K];
+        for (int j = 0; j < K; j++) {
+            out[j] = v;
+        }
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+
+// When the repeat fits inside a vector we broadcast the value and store the full vector
+// The next value overwrites the extra copies so each value takes one store
+// The last few values are done with scalar code so we don't write past the end of y
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static inline
+void u16_repeat_ssse3(const uint16_t* x, uint16_t* y, const int N, const int K) {
+    constexpr int L = 8;
+    if (K > L) {
+        u16_repeat_scalar(x, y, N, K);
+        return;
+    }
+
+    // i*K + L <= N*K
+    const int N_total = N*K;
+    int N_vector = (N_total >= L) ? ((N_total-L)/K + 1) : 0;
+    N_vector = (N_vector > N) ? N : N_vector;
+    const int N_remain = N-N_vector;
+
+    for (int i = 0; i < N_vector; i++) {
+        const __m128i v = _mm_set1_epi16((short)x[i]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&y[i*K]), v);
+    }
+    u16_repeat_scalar(&x[N_vector], &y[N_vector*K], N_remain, K);
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline
+void u16_repeat_avx2(const uint16_t* x, uint16_t* y, const int N, const int K) {
+    constexpr int L = 16;
+    if (K > L) {
+        u16_repeat_scalar(x, y, N, K);
+        return;
+    }
+
+    // i*K + L <= N*K
+    const int N_total = N*K;
+    int N_vector = (N_total >= L) ? ((N_total-L)/K + 1) : 0;
+    N_vector = (N_vector > N) ? N : N_vector;
+    const int N_remain = N-N_vector;
+
+    for (int i = 0; i < N_vector; i++) {
+        const __m256i v = _mm256_set1_epi16((short)x[i]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[i*K]), v);
+    }
+    u16_repeat_scalar(&x[N_vector], &y[N_vector*K], N_remain, K);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+void u16_repeat_auto(const uint16_t* x, uint16_t* y, const int N, const int K) {
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &u16_repeat_scalar, &u16_repeat_ssse3, &u16_repeat_avx2);
+    func(x, y, N, K);
+    #elif defined(_DSP_AVX2)
+    u16_repeat_avx2(x, y, N, K);
+    #elif defined(_DSP_SSSE3)
+    u16_repeat_ssse3(x, y, N, K);
+    #else
+    u16_repeat_scalar(x, y, N, K);
+    #endif
+}
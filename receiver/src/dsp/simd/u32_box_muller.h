@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+
+// Convert pairs of uniform random integers into complex gaussian noise using the Box-Muller transform
+// y[i] = sigma*sqrt(-2*ln(r)) * exp(j*theta)
+// r = magnitude from the top 24bits of u0[i] as (0,1]
+// theta = angle from u1[i] as a 32bit fixed point fraction of a full cycle
+// sigma = standard deviation of both the real and imaginary components
+// NOTE: The vectorised versions use polynomial approximations with a relative error below 1e-6
+
+static inline
+void u32_box_muller_scalar(const uint32_t* u0, const uint32_t* u1, std::complex<float>* y, const int N, const float sigma) {
+    constexpr float MAGNITUDE_SCALE = 1.0f/16777216.0f;
+    constexpr float ANGLE_SCALE = 6.283185307179586f/4294967296.0f;
+    for (int i = 0; i < N; i++) {
+        const float r = (float)((u0[i] >> 8) + 1u) * MAGNITUDE_SCALE;
+        const float theta = (float)u1[i] * ANGLE_SCALE;
+        const float A = sigma*std::sqrt(-2.0f*std::log(r));
+        y[i] = std::complex<float>(A*std::cos(theta), A*std::sin(theta));
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+// ln(x) for x > 0
+// x = 2^e * m where m is moved into [sqrt(1/2), sqrt(2))
+// ln(m) = 2*atanh(s) = 2*(s + s^3/3 + s^5/5 + ...) where s = (m-1)/(m+1) and |s| < 0.172
+static inline
+__m256 u32_box_muller_log_avx2(__m256 x) {
+    const __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+        _mm256_set1_epi32(0x3F800000)));
+
+    const __m256 is_upper = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), is_upper);
+    e = _mm256_sub_epi32(e, _mm256_castps_si256(is_upper));
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+    const __m256 s2 = _mm256_mul_ps(s, s);
+    __m256 p = _mm256_set1_ps(1.0f/9.0f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(1.0f/7.0f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(1.0f/5.0f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(1.0f/3.0f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, s2), one);
+    const __m256 ln_m = _mm256_mul_ps(_mm256_mul_ps(p, s), _mm256_set1_ps(2.0f));
+    return _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(e), _mm256_set1_ps(0.693147180559945f)), ln_m);
+}
+
+// cos and sin of a 32bit fixed point fraction of a cycle
+// The top 2 bits select the quadrant and the rest is an angle of [0,pi/2)
+// This angle is centered as x = angle - pi/4 so the taylor series only needs |x| <= pi/4
+// cos(x+pi/4) = (cos(x) - sin(x))/sqrt(2)
+// sin(x+pi/4) = (cos(x) + sin(x))/sqrt(2)
+static inline
+void u32_box_muller_sincos_avx2(__m256i phase, __m256& c, __m256& s) {
+    constexpr float PI = 3.14159265358979323846f;
+    const __m256i quadrant = _mm256_srli_epi32(phase, 30);
+    const __m256 frac = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_and_si256(phase, _mm256_set1_epi32(0x3FFFFFFF))),
+        _mm256_set1_ps(1.0f/1073741824.0f));
+    const __m256 x = _mm256_mul_ps(_mm256_sub_ps(frac, _mm256_set1_ps(0.5f)), _mm256_set1_ps(PI/2.0f));
+    const __m256 x2 = _mm256_mul_ps(x, x);
+
+    __m256 sx = _mm256_set1_ps(1.0f/362880.0f);
+    sx = _mm256_add_ps(_mm256_mul_ps(sx, x2), _mm256_set1_ps(-1.0f/5040.0f));
+    sx = _mm256_add_ps(_mm256_mul_ps(sx, x2), _mm256_set1_ps(1.0f/120.0f));
+    sx = _mm256_add_ps(_mm256_mul_ps(sx, x2), _mm256_set1_ps(-1.0f/6.0f));
+    sx = _mm256_add_ps(_mm256_mul_ps(sx, x2), _mm256_set1_ps(1.0f));
+    sx = _mm256_mul_ps(sx, x);
+
+    __m256 cx = _mm256_set1_ps(1.0f/40320.0f);
+    cx = _mm256_add_ps(_mm256_mul_ps(cx, x2), _mm256_set1_ps(-1.0f/720.0f));
+    cx = _mm256_add_ps(_mm256_mul_ps(cx, x2), _mm256_set1_ps(1.0f/24.0f));
+    cx = _mm256_add_ps(_mm256_mul_ps(cx, x2), _mm256_set1_ps(-1.0f/2.0f));
+    cx = _mm256_add_ps(_mm256_mul_ps(cx, x2), _mm256_set1_ps(1.0f));
+
+    const __m256 inv_sqrt2 = _mm256_set1_ps(0.70710678f);
+    const __m256 c0 = _mm256_mul_ps(_mm256_sub_ps(cx, sx), inv_sqrt2);
+    const __m256 s0 = _mm256_mul_ps(_mm256_add_ps(cx, sx), inv_sqrt2);
+
+    // quadrant 0: ( c0,  s0)
+    // quadrant 1: (-s0,  c0)
+    // quadrant 2: (-c0, -s0)
+    // quadrant 3: ( s0, -c0)
+    const __m256 is_swap = _mm256_castsi256_ps(_mm256_sub_epi32(
+        _mm256_setzero_si256(), _mm256_and_si256(quadrant, _mm256_set1_epi32(0b1))));
+    const __m256 c1 = _mm256_blendv_ps(c0, s0, is_swap);
+    const __m256 s1 = _mm256_blendv_ps(s0, c0, is_swap);
+    const __m256i c_sign = _mm256_slli_epi32(
+        _mm256_xor_si256(quadrant, _mm256_srli_epi32(quadrant, 1)), 31);
+    const __m256i s_sign = _mm256_slli_epi32(_mm256_srli_epi32(quadrant, 1), 31);
+    c = _mm256_xor_ps(c1, _mm256_castsi256_ps(c_sign));
+    s = _mm256_xor_ps(s1, _mm256_castsi256_ps(s_sign));
+}
+
+static inline
+void u32_box_muller_avx2(const uint32_t* u0, const uint32_t* u1, std::complex<float>* y, const int N, const float sigma) {
+    constexpr int K = 8;
+    const int M = N/K;
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+
+    const __m256 magnitude_scale = _mm256_set1_ps(1.0f/16777216.0f);
+    const __m256 minus_two_sigma2 = _mm256_set1_ps(-2.0f*sigma*sigma);
+    for (int i = 0; i < N_vector; i += K) {
+        const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&u0[i]));
+        const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&u1[i]));
+        const __m256 r = _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_srli_epi32(a0, 8), _mm256_set1_epi32(1))),
+            magnitude_scale);
+        const __m256 A = _mm256_sqrt_ps(_mm256_mul_ps(minus_two_sigma2, u32_box_muller_log_avx2(r)));
+        __m256 c, s;
+        u32_box_muller_sincos_avx2(a1, c, s);
+        const __m256 re = _mm256_mul_ps(A, c);
+        const __m256 im = _mm256_mul_ps(A, s);
+        // [r0 i0 r1 i1 | r4 i4 r5 i5] and [r2 i2 r3 i3 | r6 i6 r7 i7]
+        const __m256 lo = _mm256_unpacklo_ps(re, im);
+        const __m256 hi = _mm256_unpackhi_ps(re, im);
+        float* out = reinterpret_cast<float*>(&y[i]);
+        _mm256_storeu_ps(&out[0], _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(&out[8], _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    u32_box_muller_scalar(&u0[N_vector], &u1[N_vector], &y[N_vector], N_remain, sigma);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+void u32_box_muller_auto(const uint32_t* u0, const uint32_t* u1, std::complex<float>* y, const int N, const float sigma) {
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &u32_box_muller_scalar, &u32_box_muller_scalar, &u32_box_muller_avx2);
+    func(u0, u1, y, N, sigma);
+    #elif defined(_DSP_AVX2)
+    u32_box_muller_avx2(u0, u1, y, N, sigma);
+    #else
+    u32_box_muller_scalar(u0, u1, y, N, sigma);
+    #endif
+}
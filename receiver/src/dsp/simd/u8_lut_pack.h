@@ -0,0 +1,107 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+
+// Map symbols through a lookup table and pack them msb first into bytes
+// x = symbols with nb_bits each, one symbol per byte
+// y = packed output of N*nb_bits/8 bytes
+// lut = lookup table with 2^nb_bits entries, e.g. to rotate symbols by a phase
+// NOTE: N*nb_bits must be a whole number of bytes
+
+static inline
+void u8_lut_pack_scalar(const uint8_t* x, uint8_t* y, const uint8_t* lut, const int N, const int nb_bits) {
+    assert(((N*nb_bits) % 8) == 0);
+    uint32_t acc = 0;
+    int nb_acc = 0;
+    int j = 0;
+    for (int i = 0; i < N; i++) {
+        acc = (acc << nb_bits) | lut[x[i]];
+        nb_acc += nb_bits;
+        while (nb_acc >= 8) {
+            nb_acc -= 8;
+            y[j++] = (uint8_t)(acc >> nb_acc);
+        }
+        acc &= (1u << nb_acc) - 1u;
+    }
+}
+
+static inline
+void u8_lut_pack_nibble_scalar(const uint8_t* x, uint8_t* y, const uint8_t* lut, const int N) {
+    u8_lut_pack_scalar(x, y, lut, N, 4);
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+
+// Nibble symbols use the 16 entry lookup table directly as a byte shuffle
+// Pairs of symbols are combined with a multiply add as (x[2i] << 4) | x[2i+1]
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static inline
+void u8_lut_pack_nibble_ssse3(const uint8_t* x, uint8_t* y, const uint8_t* lut, const int N) {
+    // 2 symbols per byte
+    constexpr int K = 32;
+    const int M = N/K;
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+
+    const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut));
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    for (int i = 0; i < N_vector; i += K) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i+16]));
+        a = _mm_maddubs_epi16(_mm_shuffle_epi8(table, a), weights);
+        b = _mm_maddubs_epi16(_mm_shuffle_epi8(table, b), weights);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&y[i/2]), _mm_packus_epi16(a, b));
+    }
+    u8_lut_pack_scalar(&x[N_vector], &y[N_vector/2], lut, N_remain, 4);
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline
+void u8_lut_pack_nibble_avx2(const uint8_t* x, uint8_t* y, const uint8_t* lut, const int N) {
+    // 2 symbols per byte
+    constexpr int K = 64;
+    const int M = N/K;
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut)));
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    for (int i = 0; i < N_vector; i += K) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x[i]));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x[i+32]));
+        a = _mm256_maddubs_epi16(_mm256_shuffle_epi8(table, a), weights);
+        b = _mm256_maddubs_epi16(_mm256_shuffle_epi8(table, b), weights);
+        // pack works within each 128bit lane so we need to permute the lanes back into order
+        const __m256i c = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0b11011000);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[i/2]), c);
+    }
+    u8_lut_pack_scalar(&x[N_vector], &y[N_vector/2], lut, N_remain, 4);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+void u8_lut_pack_auto(const uint8_t* x, uint8_t* y, const uint8_t* lut, const int N, const int nb_bits) {
+    if (nb_bits != 4) {
+        u8_lut_pack_scalar(x, y, lut, N, nb_bits);
+        return;
+    }
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &u8_lut_pack_nibble_scalar, &u8_lut_pack_nibble_ssse3, &u8_lut_pack_nibble_avx2);
+    func(x, y, lut, N);
+    #elif defined(_DSP_AVX2)
+    u8_lut_pack_nibble_avx2(x, y, lut, N);
+    #elif defined(_DSP_SSSE3)
+    u8_lut_pack_nibble_ssse3(x, y, lut, N);
+    #else
+    u8_lut_pack_scalar(x, y, lut, N, nb_bits);
+    #endif
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+// y[i] = x0[i] ^ x1[i]
+// NOTE: y can be the same array as x0 or x1
+
+static inline
+void u8_xor_scalar(const uint8_t* x0, const uint8_t* x1, uint8_t* y, const int N) {
+    for (int i = 0; i < N; i++) {
+        y[i] = x0[i] ^ x1[i];
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "cpu_features.h"
+
+#if defined(_DSP_BUILD_SSSE3)
+DSP_TARGET_SSSE3_BEGIN
+static inline
+void u8_xor_ssse3(const uint8_t* x0, const uint8_t* x1, uint8_t* y, const int N) {
+    constexpr int K = 16;
+    const int M = N/K;
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+
+    for (int i = 0; i < N_vector; i += K) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x0[i]));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x1[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&y[i]), _mm_xor_si128(a, b));
+    }
+    u8_xor_scalar(&x0[N_vector], &x1[N_vector], &y[N_vector], N_remain);
+}
+DSP_TARGET_END
+#endif
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline
+void u8_xor_avx2(const uint8_t* x0, const uint8_t* x1, uint8_t* y, const int N) {
+    constexpr int K = 32;
+    const int M = N/K;
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+
+    for (int i = 0; i < N_vector; i += K) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x0[i]));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&x1[i]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[i]), _mm256_xor_si256(a, b));
+    }
+    u8_xor_scalar(&x0[N_vector], &x1[N_vector], &y[N_vector], N_remain);
+}
+DSP_TARGET_END
+#endif
+
+inline static
+void u8_xor_auto(const uint8_t* x0, const uint8_t* x1, uint8_t* y, const int N) {
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &u8_xor_scalar, &u8_xor_ssse3, &u8_xor_avx2);
+    func(x0, x1, y, N);
+    #elif defined(_DSP_AVX2)
+    u8_xor_avx2(x0, x1, y, N);
+    #elif defined(_DSP_SSSE3)
+    u8_xor_ssse3(x0, x1, y, N);
+    #else
+    u8_xor_scalar(x0, x1, y, N);
+    #endif
+}
\ No newline at end of file
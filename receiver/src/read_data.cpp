@@ -30,6 +30,9 @@ void usage() {
         "\t    If no file is provided then stdin is used\n"
         "\t[-g audio gain (default: 100)]\n"
         "\t[-A toggle audio output (default: true)]\n"
+        "\t[-P run demodulator and decoder as a multithreaded pipeline (default: false)]\n"
+        "\t[-V decode frames in batches with the SIMD viterbi decoder (default: false)]\n"
+        "\t[-T decode frames as they arrive with this viterbi traceback depth (default: none)]\n"
         "\t[-h (show usage)]\n"
     );
 }
@@ -47,9 +50,12 @@ int main(int argc, char **argv) {
     // audio stream is symbol_rate / N
     const int audio_packet_sampling_ratio = 5;
     bool is_output_audio = true;
+    bool is_pipelined = false;
+    bool is_batch_viterbi = false;
+    int viterbi_traceback_depth = 0;
 
     int opt; 
-    while ((opt = getopt_custom(argc, argv, "f:s:b:D:S:i:g:Ah")) != -1) {
+    while ((opt = getopt_custom(argc, argv, "f:s:b:D:S:i:g:APVT:h")) != -1) {
         switch (opt) {
         case 'f':
             Fsample = (float)(atof(optarg));
@@ -99,6 +105,19 @@ int main(int argc, char **argv) {
         case 'A':
             is_output_audio = false;
             break;
+        case 'P':
+            is_pipelined = true;
+            break;
+        case 'V':
+            is_batch_viterbi = true;
+            break;
+        case 'T':
+            viterbi_traceback_depth = (int)(atof(optarg));
+            if (viterbi_traceback_depth <= 0) {
+                fprintf(stderr, "Viterbi traceback depth must be positive (%d)\n", viterbi_traceback_depth);
+                return 1;
+            }
+            break;
         case 'h':
         default:
             usage();
@@ -128,10 +147,14 @@ int main(int argc, char **argv) {
     const int audio_buffer_size = (int)Faudio;
     const int decoder_block_size = 1024;
 
+    // There is no visualisation so we skip the per sample diagnostic buffers
+    const bool is_diagnostics = false;
+    auto rx_source = FileSampleSource(fp_in);
     auto app = App(
-        fp_in, demod_block_size, 
+        rx_source, demod_block_size, 
         decoder_block_size, ds_factor, us_factor, 
-        audio_buffer_size, Faudio);
+        audio_buffer_size, Faudio, 
+        is_diagnostics);
 
     {
         const float PI = 3.1415f;
@@ -183,6 +206,14 @@ int main(int argc, char **argv) {
     pa_output.GetMixer().GetOutputGain() = (float)audio_gain / 100.0f;
 
     app.GetFrameHandler().is_output_audio = is_output_audio;
+    if (is_batch_viterbi && (viterbi_traceback_depth > 0)) {
+        fprintf(stderr, "Batch and streaming viterbi decoding cannot be used together\n");
+        return 1;
+    }
+    app.GetFrameDecoder().SetBatchViterbi(is_batch_viterbi);
+    if (viterbi_traceback_depth > 0) {
+        app.GetFrameDecoder().SetStreamingViterbi(true, viterbi_traceback_depth);
+    }
 
     app.GetAudioFilter().OnOutputBlock().Attach([&pcm_player, Faudio](tcb::span<const Frame<float>> data) {
         pcm_player->SetInputSampleRate((int)Faudio);
@@ -190,7 +221,11 @@ int main(int argc, char **argv) {
     });
     
     app.BuildDemodulator();
-    app.Run();
+    if (is_pipelined) {
+        app.RunPipelined();
+    } else {
+        app.Run();
+    }
 
     return 0;
 }
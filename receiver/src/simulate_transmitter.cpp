@@ -14,11 +14,12 @@
 #include <vector>
 #include <cstring>
 #include <algorithm>
+#include <memory>
 
-#include "decoder/convolutional_encoder.h"
-#include "decoder/additive_scrambler.h"
-#include "decoder/crc32.h"
-#include "decoder/crc8.h"
+#include "simulator/frame_encoder.h"
+#include "simulator/iq_modulator.h"
+#include "simulator/parallel_modulator.h"
+#include "simulator/channel_model.h"
 
 #include "utility/getopt/getopt.h"
 #include "utility/span.h"
@@ -28,33 +29,7 @@
 #include <fcntl.h>
 #endif
 
-struct IQ_Symbol {
-    uint8_t I;
-    uint8_t Q;
-};
-
-template <typename T>
-int push_big_endian_byte(uint8_t* x, T y) {
-    auto y_addr = reinterpret_cast<uint8_t*>(&y);
-    const int N = sizeof(y) / sizeof(uint8_t);
-    for (int i = 0; i < N; i++) {
-        x[i] = y_addr[N-1-i];
-    }
-    return N;
-}
-
-// pad preamble bits to be byte aligned
-// 2x13-barker codes and 1x2-code and 1x4-code
-constexpr uint8_t CONV_POLY[CODE_RATE] = { 0b111, 0b101 };
-constexpr uint32_t PREAMBLE_CODE = 0b11111001101011111100110101101101;
-constexpr uint16_t SCRAMBLER_CODE = 0b1000010101011001;
-constexpr uint32_t CRC32_POLY = 0x04C11DB7;
-constexpr uint8_t CRC8_POLY = 0xD5;
-
-auto enc = ConvolutionalEncoder(CONV_POLY);
-auto scrambler = AdditiveScrambler(SCRAMBLER_CODE);
-auto crc32_calc = CRC32_Calculator(CRC32_POLY);
-auto crc8_calc = CRC8_Calculator(CRC8_POLY);
+auto frame_encoder = FrameEncoder();
 
 void usage() {
     fprintf(stderr, 
@@ -62,20 +37,29 @@ void usage() {
         "Usage:\t[-D (dump encoded IQ symbols out to stdout)]\n"
         "\t[-h (show usage)]\n"
         "\t[-R (dont run in real time)]\n"
+        "\t[-j number of threads when not in real time (default: all)]\n"
         "\t[-f sample rate (default: 2MHz)]\n"
         "\t[-s symbol rate (default: 50kHz)]\n"
         "\t[-b block size (default: 4096)]\n"
         "\t[-t recording time (default: 1s)]\n"
         "\t[-m modulation type (default: 16qam)]\n"
         "\t    options: [16QAM, 4QAM]\n"
+        "Channel impairments:\n"
+        "\t[-n Es/N0 of additive white gaussian noise in dB (default: no noise)]\n"
+        "\t[-c carrier frequency offset in Hz (default: 0)]\n"
+        "\t[-p carrier phase noise in radians per sample (default: 0)]\n"
+        "\t[-d sample clock drift in ppm (default: 0)]\n"
+        "\t[-M multipath echos as delay:amplitude[:phase_degrees] separated by commas (default: none)]\n"
+        "\t    example: -M 3:0.2,7:0.1:90\n"
+        "\t[-S seed for the random noise (default: 0)]\n"
     );
 }
 
-void create_frame(tcb::span<const uint8_t> input_data, tcb::span<uint8_t> output_data);
 std::vector<uint8_t> create_test_data();
 std::vector<uint8_t> create_audio_data();
-int create_16QAM_symbols(uint8_t x, tcb::span<IQ_Symbol> syms);
-int create_4QAM_symbols(uint8_t x, tcb::span<IQ_Symbol> syms);
+int write_blocks_offline(const IQ_Modulator& modulator, const int block_size, const int total_blocks, const int nb_threads);
+int write_blocks_offline_channel(ChannelModel& channel, const int block_size, const int total_blocks);
+bool parse_multipath(const char* arg, std::vector<std::complex<float>>& taps);
 
 template <typename T>
 void extend_vector(std::vector<T>& dst, std::vector<T>&& src) {
@@ -96,11 +80,14 @@ int main(int argc, char** argv) {
     float Fsym = 50e3;
     int block_size = 4096;
     float recording_time = 1.0f;
+    int nb_threads = 0;
+    ChannelSpecification channel_spec;
+    float carrier_offset = 0.0f;
+    bool is_channel = false;
 
-    enum ModulationType { QAM16, QPSK };
     ModulationType modulation_type = ModulationType::QAM16;
 
-    while ((opt = getopt_custom(argc, argv, "s:b:t:m:f:DhR")) != -1) {
+    while ((opt = getopt_custom(argc, argv, "s:b:t:m:f:j:n:c:p:d:M:S:DhR")) != -1) {
         switch (opt) {
         case 'D':
             is_dumping = true;
@@ -120,6 +107,9 @@ int main(int argc, char** argv) {
         case 'b':
             block_size = static_cast<int>(atof(optarg));
             break;
+        case 'j':
+            nb_threads = static_cast<int>(atof(optarg));
+            break;
         case 't':
             recording_time = static_cast<float>(atof(optarg));
             break;
@@ -135,11 +125,38 @@ int main(int argc, char** argv) {
                 return 1;
             }
             break;
+        case 'n':
+            channel_spec.EsN0_dB = static_cast<float>(atof(optarg));
+            is_channel = true;
+            break;
+        case 'c':
+            carrier_offset = static_cast<float>(atof(optarg));
+            is_channel = true;
+            break;
+        case 'p':
+            channel_spec.phase_noise = static_cast<float>(atof(optarg));
+            is_channel = true;
+            break;
+        case 'd':
+            channel_spec.timing_drift_ppm = static_cast<float>(atof(optarg));
+            is_channel = true;
+            break;
+        case 'M':
+            if (!parse_multipath(optarg, channel_spec.multipath)) {
+                fprintf(stderr, "Invalid multipath echos: %s\n", optarg);
+                return 1;
+            }
+            is_channel = true;
+            break;
+        case 'S':
+            channel_spec.seed = static_cast<uint64_t>(atof(optarg));
+            break;
         case '?':
             usage();
             return 0;
         }
     }
+    channel_spec.carrier_offset = carrier_offset / Fs;
     
 #if _WIN32
     // NOTE: Windows does extra translation stuff that messes up the file if this isn't done
@@ -164,182 +181,163 @@ int main(int argc, char** argv) {
     const float F_block = Fs/(float)(block_size);
     const float T_block = 1.0f/F_block;
     const int N_blocks = static_cast<int>(std::ceil(recording_time/T_block));
-    int curr_block = 0;
     
     // number of samples per symbol
     const int Nsamples = (int)std::round(Fs/Fsym);
     const int T_block_microseconds = static_cast<int>(std::ceil(T_block * 1e6));
     
+    auto modulator = IQ_Modulator(modulation_type, Nsamples);
+    modulator.SetData(test_data);
+
+    // ideal samples are generated directly by the modulator
+    auto channel = std::unique_ptr<ChannelModel>(nullptr);
+    if (is_channel) {
+        channel = std::make_unique<ChannelModel>(channel_spec, modulator);
+    }
+
+    if (!is_real_time) {
+        if (channel) {
+            return write_blocks_offline_channel(*channel, block_size, N_blocks);
+        }
+        return write_blocks_offline(modulator, block_size, N_blocks, nb_threads);
+    }
+
     auto tx_block = std::vector<uint8_t>(block_size*2);
-    int curr_tx_block_idx = 0;
-    IQ_Symbol sym_out[8];
-    // convert to symbols
+    uint64_t curr_sample = 0;
     auto dt_prev_tx = std::chrono::high_resolution_clock::now();
     while (1) {
-        for (int i = 0; i < test_data.size(); i++) {
-            const auto x = test_data[i];
-            int total_symbols = 0;
-            switch (modulation_type) {
-            case ModulationType::QAM16:
-                total_symbols = create_16QAM_symbols(x, sym_out);
-                break;
-            case ModulationType::QPSK:
-            default:
-                total_symbols = create_4QAM_symbols(x, sym_out);
-                break;
-            }
+        if (channel) {
+            channel->Generate(tx_block);
+        } else {
+            modulator.Generate(tx_block, curr_sample);
+        }
+        curr_sample += (uint64_t)block_size;
 
-            for (int j = 0; j < total_symbols; j++) {
-                auto sym = sym_out[j];
-
-                for (int k = 0; k < Nsamples; k++) {
-                    tx_block[curr_tx_block_idx  ] = sym.I;
-                    tx_block[curr_tx_block_idx+1] = sym.Q;
-                    curr_tx_block_idx += 2;
-
-                    // transmit the block
-                    if (curr_tx_block_idx >= tx_block.size()) {
-                        const size_t nb_write = fwrite(tx_block.data(), sizeof(uint8_t), tx_block.size(), stdout);
-                        if (nb_write != tx_block.size()) {
-                            fprintf(stderr, "Failed to write symbol %zu/%zu\n", nb_write, tx_block.size());
-                            return 0;
-                        }
-                        curr_tx_block_idx = 0;
-                        curr_block++;
-
-                        // if it is real time, add a delay
-                        if (is_real_time) {
-                            auto dt_curr_tx = std::chrono::high_resolution_clock::now();
-                            const auto dt = std::chrono::duration_cast<std::chrono::microseconds>(dt_curr_tx-dt_prev_tx);
-                            int T_offset =  static_cast<int>(dt.count());
-                            int delay = T_offset - T_block_microseconds;
-                            dt_prev_tx = dt_curr_tx;
-                            std::this_thread::sleep_for(std::chrono::microseconds((T_block_microseconds - delay)/2));
-                        // if this isn't real time, we will impose a time recording limit
-                        } else {
-                            if (curr_block >= N_blocks) {
-                                return 0;
-                            }
-                        }
-                   }
-                }
-            }
+        // transmit the block
+        const size_t nb_write = fwrite(tx_block.data(), sizeof(uint8_t), tx_block.size(), stdout);
+        if (nb_write != tx_block.size()) {
+            fprintf(stderr, "Failed to write symbol %zu/%zu\n", nb_write, tx_block.size());
+            return 0;
         }
+
+        // real time requires a delay
+        auto dt_curr_tx = std::chrono::high_resolution_clock::now();
+        const auto dt = std::chrono::duration_cast<std::chrono::microseconds>(dt_curr_tx-dt_prev_tx);
+        int T_offset =  static_cast<int>(dt.count());
+        int delay = T_offset - T_block_microseconds;
+        dt_prev_tx = dt_curr_tx;
+        std::this_thread::sleep_for(std::chrono::microseconds((T_block_microseconds - delay)/2));
     }
     return 0;
 }
 
-int create_16QAM_symbols(uint8_t x, tcb::span<IQ_Symbol> syms) {
-    static const uint8_t _gray_code[4] = {0b00, 0b01, 0b11, 0b10};
-
-    uint8_t I1 = (x & 0b11000000) >> 6;
-    uint8_t Q1 = (x & 0b00110000) >> 4;
-    uint8_t I2 = (x & 0b00001100) >> 2;
-    uint8_t Q2 = (x & 0b00000011);
-
-    const int A = 64;
-    const int B = 128;
-    // Average of QAM signal is 1.5 = (0+1+2+3)/4 = 6/4 = 3/2
-    const int DC = (uint8_t)((float)A * 1.5f);
-
-    static auto get_val = [A,B,DC](uint8_t v) {
-        int x = (int)_gray_code[v];
-        x = x*A + B - DC;
-        return (uint8_t)x;        
-    };
-
-    I1 = get_val(I1);
-    Q1 = get_val(Q1);
-    I2 = get_val(I2);
-    Q2 = get_val(Q2);
-
-    syms[0].I = I1;
-    syms[0].Q = Q1;
-    syms[1].I = I2;
-    syms[1].Q = Q2;
-
-    return 2;
-}
-
-int create_4QAM_symbols(uint8_t x, tcb::span<IQ_Symbol> syms) {
-    // NOTE: 4QAM is already gray code by itself
-    const uint8_t A = 64;
-    const uint8_t B = 128;
-    // Average amplitude is 0.5 = (0+1)/2 = 0.5
-    const uint8_t DC = A/2;
-
-    static auto get_val = [A,B,DC](uint8_t v) {
-        const int x = (int)v*A + B - DC;
-        return (uint8_t)x;        
+// If this isn't real time, we will impose a time recording limit
+// Blocks are generated in large batches across all threads
+// Each batch is written out in a single call while the workers generate the next one
+int write_blocks_offline(const IQ_Modulator& modulator, const int block_size, const int total_blocks, const int nb_threads) {
+    constexpr int MIN_BATCH_SAMPLES = 1 << 21;
+    const int blocks_per_batch = std::max(1, MIN_BATCH_SAMPLES / block_size);
+    const size_t batch_length = (size_t)blocks_per_batch * (size_t)block_size * 2;
+    std::vector<uint8_t> batches[2] = { std::vector<uint8_t>(batch_length), std::vector<uint8_t>(batch_length) };
+
+    auto parallel_modulator = ParallelModulator(modulator, nb_threads);
+    auto start_batch = [&](const int batch, const int start_block) {
+        const int nb_blocks = std::min(blocks_per_batch, total_blocks-start_block);
+        auto iq = tcb::span(batches[batch]).first((size_t)nb_blocks * (size_t)block_size * 2);
+        parallel_modulator.Start(iq, (uint64_t)start_block * (uint64_t)block_size);
+        return iq;
     };
 
-    int j = 0;
-    for (int i = 0; i < 8; i+=2) {
-        const int shift = 7-i;
-        uint8_t I = (x >> shift    ) & 0x1;
-        uint8_t Q = (x >> (shift-1)) & 0x1;
-        syms[j].I = get_val(I);
-        syms[j].Q = get_val(Q);
-        j++;
-    }
-    return 4;
-}
+    const auto dt_start = std::chrono::high_resolution_clock::now();
+    int curr_block = 0;
+    int curr_batch = 0;
+    auto iq = start_batch(curr_batch, curr_block);
+    while (curr_block < total_blocks) {
+        parallel_modulator.Wait();
+        const auto curr_iq = iq;
+        curr_block += (int)(curr_iq.size() / ((size_t)block_size*2));
+        curr_batch = 1-curr_batch;
+        if (curr_block < total_blocks) {
+            iq = start_batch(curr_batch, curr_block);
+        }
 
-void create_frame(tcb::span<const uint8_t> input_data, tcb::span<uint8_t> output_data) {
-    // encoding size is given as the following
-    // 4: preamble
-    // additive scrambler + fec of 1/2 K=3 [7,5] code
-    // 2: length of payload
-    // N: payload
-    // 1: CRC8 
-    // 1: NULL trellis terminator
-
-    // T = 4 + 2*(2+N+1+1)
-    // T = 2N + 12
-    const size_t expected_output_size = 2*input_data.size() + 12;
-    assert(expected_output_size == output_data.size());
-
-    const size_t Nx = input_data.size();
-    const size_t Ny = output_data.size();
-    auto x = input_data;
-    auto y = output_data;
-
-    int offset = 0;
-    offset += push_big_endian_byte(&y[offset], PREAMBLE_CODE);
-
-    const int scrambler_offset = offset;
-
-    enc.reset();
-    scrambler.reset();
-
-    uint16_t Nx_copy = static_cast<uint16_t>(Nx);
-    auto Nx_addr = reinterpret_cast<uint8_t*>(&Nx_copy);
-    for (int i = 0; i < sizeof(Nx_copy); i++) {
-        auto enc_out = enc.consume_byte(Nx_addr[i]);
-        offset += push_big_endian_byte(&y[offset], enc_out);
+        const size_t nb_write = fwrite(curr_iq.data(), sizeof(uint8_t), curr_iq.size(), stdout);
+        if (nb_write != curr_iq.size()) {
+            fprintf(stderr, "Failed to write symbol %zu/%zu\n", nb_write, curr_iq.size());
+            parallel_modulator.Wait();
+            return 0;
+        }
     }
+    const auto dt_end = std::chrono::high_resolution_clock::now();
 
-    for (int i = 0; i < Nx; i++) {
-        auto enc_out = enc.consume_byte(x[i]);
-        offset += push_big_endian_byte(&y[offset], enc_out);
-    }
+    const double total_samples = (double)total_blocks * (double)block_size;
+    const double dt = (double)std::chrono::duration_cast<std::chrono::microseconds>(dt_end-dt_start).count();
+    fprintf(stderr, "Wrote %.0f samples using %d threads at %.2f MS/s\n",
+        total_samples, parallel_modulator.GetTotalThreads(), total_samples / dt);
+    return 0;
+}
 
-    uint8_t crc8 = crc8_calc.process(x.data(), int(x.size()));
-    auto crc8_addr = reinterpret_cast<uint8_t*>(&crc8);
-    for (int i = 0; i < sizeof(crc8); i++) {
-        auto enc_out = enc.consume_byte(crc8_addr[i]);
-        offset += push_big_endian_byte(&y[offset], enc_out);
+// The channel is stateful so the blocks are generated in order on a single thread
+int write_blocks_offline_channel(ChannelModel& channel, const int block_size, const int total_blocks) {
+    constexpr int MIN_BATCH_SAMPLES = 1 << 18;
+    const int blocks_per_batch = std::max(1, MIN_BATCH_SAMPLES / block_size);
+    auto batch = std::vector<uint8_t>((size_t)blocks_per_batch * (size_t)block_size * 2);
+
+    const auto dt_start = std::chrono::high_resolution_clock::now();
+    for (int curr_block = 0; curr_block < total_blocks; curr_block += blocks_per_batch) {
+        const int nb_blocks = std::min(blocks_per_batch, total_blocks-curr_block);
+        auto iq = tcb::span(batch).first((size_t)nb_blocks * (size_t)block_size * 2);
+        channel.Generate(iq);
+        const size_t nb_write = fwrite(iq.data(), sizeof(uint8_t), iq.size(), stdout);
+        if (nb_write != iq.size()) {
+            fprintf(stderr, "Failed to write symbol %zu/%zu\n", nb_write, iq.size());
+            return 0;
+        }
     }
+    const auto dt_end = std::chrono::high_resolution_clock::now();
 
-    {
-        uint8_t trellis_terminator = 0x00;
-        auto enc_out = enc.consume_byte(trellis_terminator);
-        offset += push_big_endian_byte(&y[offset], enc_out);
-    }
+    const double total_samples = (double)total_blocks * (double)block_size;
+    const double dt = (double)std::chrono::duration_cast<std::chrono::microseconds>(dt_end-dt_start).count();
+    fprintf(stderr, "Wrote %.0f samples through the channel at %.2f MS/s\n", total_samples, total_samples / dt);
+    return 0;
+}
 
-    for (int i = scrambler_offset; i < offset; i++) {
-        y[i] = scrambler.process(y[i]);
+// delay:amplitude[:phase_degrees] separated by commas
+// The direct path has a delay of 0 and an amplitude of 1 unless it is given
+bool parse_multipath(const char* arg, std::vector<std::complex<float>>& taps) {
+    constexpr float PI = 3.14159265358979323846f;
+    constexpr int MAX_DELAY = 256;
+    taps.clear();
+    taps.push_back(1.0f);
+    bool is_direct_given = false;
+    const char* curr = arg;
+    while (*curr) {
+        int delay = 0;
+        float amplitude = 0.0f;
+        float phase = 0.0f;
+        int nb_read = 0;
+        const int nb_fields = sscanf(curr, "%d:%f%n:%f%n", &delay, &amplitude, &nb_read, &phase, &nb_read);
+        if ((nb_fields < 2) || (delay < 0) || (delay > MAX_DELAY)) {
+            return false;
+        }
+        if ((int)taps.size() <= delay) {
+            taps.resize(delay+1, 0.0f);
+        }
+        const auto tap = std::polar(amplitude, phase*PI/180.0f);
+        if ((delay == 0) && !is_direct_given) {
+            taps[0] = tap;
+            is_direct_given = true;
+        } else {
+            taps[delay] += tap;
+        }
+        curr += nb_read;
+        if (*curr == ',') {
+            curr++;
+        } else if (*curr != '\0') {
+            return false;
+        }
     }
+    return true;
 }
 
 std::vector<uint8_t> create_test_data() {
@@ -351,24 +349,13 @@ std::vector<uint8_t> create_test_data() {
         "Test string 4",
     };
 
-    // encoding size is given as the following
-    // 4: preamble
-    // additive scrambler + fec of 1/2 K=3 [7,5] code
-    // 2: length of payload
-    // N: payload
-    // 1: CRC8 
-    // 1: Trellis terminator 
-
-    // T = 4 + 2*(2+N+1)
-    // T = 2N + 12
-
     size_t string_lengths[TOTAL_STRINGS] = {0};
     size_t encoded_lengths[TOTAL_STRINGS] = {0};
     size_t total_encoded_length = 0;
     for (size_t i = 0; i < TOTAL_STRINGS; i++) {
         const char* input_data = data[i];
         const size_t input_length = strlen(input_data);
-        const size_t encoded_length = 2*input_length + 12;
+        const size_t encoded_length = (size_t)FrameEncoder::GetEncodedSize((int)input_length);
 
         string_lengths[i] = input_length;
         encoded_lengths[i] = encoded_length;
@@ -380,7 +367,7 @@ std::vector<uint8_t> create_test_data() {
     for (size_t i = 0; i < TOTAL_STRINGS; i++) {
         const auto input_data = tcb::span(reinterpret_cast<const uint8_t*>(data[i]), string_lengths[i]);
         const size_t encoded_length = encoded_lengths[i];
-        create_frame(input_data, write_buffer.first(encoded_length));
+        frame_encoder.CreateFrame(input_data, write_buffer.first(encoded_length));
         write_buffer = write_buffer.subspan(encoded_length);
     }
 
@@ -390,7 +377,7 @@ std::vector<uint8_t> create_test_data() {
 std::vector<uint8_t> create_audio_data() {
     // NOTE: prototype has this value set to 100 to delineate audio packets which is an ugly hack!!!
     const size_t AUDIO_PACKET_BLOCK_SIZE = 100;
-    const size_t total_encoded_per_block = 2*AUDIO_PACKET_BLOCK_SIZE + 12;
+    const size_t total_encoded_per_block = (size_t)FrameEncoder::GetEncodedSize((int)AUDIO_PACKET_BLOCK_SIZE);
     const size_t total_audio_blocks = 1000;
     const size_t total_encoded = total_encoded_per_block * total_audio_blocks;
     
@@ -406,7 +393,7 @@ std::vector<uint8_t> create_audio_data() {
             dt += 0.1f;
         }
         // encode block
-        create_frame(block, write_buffer.first(total_encoded_per_block));
+        frame_encoder.CreateFrame(block, write_buffer.first(total_encoded_per_block));
         write_buffer = write_buffer.subspan(total_encoded_per_block);
     }
 
@@ -0,0 +1,162 @@
+#include "channel_model.h"
+#include "iq_modulator.h"
+#include <assert.h>
+#include <algorithm>
+
+constexpr double FIXED_POINT_SCALE = 4294967296.0;
+
+static uint8_t quantise(const float x) {
+    const int v = (int)(x + 128.5f);
+    return (uint8_t)((v < 0) ? 0 : ((v > 255) ? 255 : v));
+}
+
+ChannelModel::ChannelModel(const ChannelSpecification& _spec, const IQ_Modulator& _modulator)
+: spec(_spec), modulator(_modulator),
+  noise(_spec.seed), phase_noise(_spec.seed+1)
+{
+    // Es = symbol power summed over the samples of the symbol
+    // N0 = noise power of each sample which is split between the real and imaginary parts
+    noise_sigma = 0.0f;
+    if (std::isfinite(spec.EsN0_dB)) {
+        const double Es = (double)modulator.GetSymbolPower() * (double)modulator.GetSamplesPerSymbol();
+        const double EsN0 = std::pow(10.0, (double)spec.EsN0_dB/10.0);
+        noise_sigma = (float)std::sqrt(Es / EsN0 / 2.0);
+    }
+
+    const double step = (1.0 + (double)spec.timing_drift_ppm*1e-6) * FIXED_POINT_SCALE;
+    assert(step > 0.0);
+    const uint64_t step_fixed = (uint64_t)std::llround(step);
+    step_index = step_fixed >> 32;
+    step_frac = (uint32_t)(step_fixed & 0xFFFFFFFF);
+
+    // wrap the offset into [-0.5,0.5] cycles and then into an unsigned 32bit step
+    // negative steps wrap around to the same phase increment
+    const double carrier_offset = (double)spec.carrier_offset - std::round((double)spec.carrier_offset);
+    carrier_step = (uint32_t)(int64_t)std::llround(carrier_offset * FIXED_POINT_SCALE);
+    constexpr double PI = 3.14159265358979323846;
+    phase_noise_scale = (float)((double)spec.phase_noise / (2.0*PI) * FIXED_POINT_SCALE);
+
+    multipath_taps = spec.multipath;
+    if (!multipath_taps.empty()) {
+        multipath_history.resize(multipath_taps.size()-1, 0.0f);
+    }
+}
+
+void ChannelModel::Generate(tcb::span<uint8_t> iq) {
+    assert((iq.size() % 2) == 0);
+    const int N = (int)(iq.size()/2);
+    const int H = (int)multipath_history.size();
+
+    // resampled samples are placed after the history of the multipath filter
+    x_buffer.resize(H+N);
+    std::copy_n(multipath_history.begin(), H, x_buffer.begin());
+    auto x = tcb::span(x_buffer).subspan(H, N);
+    Resample(x);
+
+    auto y = x;
+    if (!multipath_taps.empty()) {
+        y_buffer.resize(N);
+        y = tcb::span(y_buffer);
+        ApplyMultipath(x_buffer, y);
+        std::copy_n(x_buffer.end()-H, H, multipath_history.begin());
+    }
+
+    if ((carrier_step != 0) || (phase_noise_scale > 0.0f)) {
+        ApplyCarrier(y);
+    }
+
+    if (noise_sigma > 0.0f) {
+        ApplyNoise(y);
+    }
+
+    for (int i = 0; i < N; i++) {
+        iq[2*i+0] = quantise(y[i].real());
+        iq[2*i+1] = quantise(y[i].imag());
+    }
+}
+
+void ChannelModel::Resample(tcb::span<std::complex<float>> y) {
+    const int N = (int)y.size();
+    // position of the last output sample determines how many input samples are needed
+    const uint64_t last_frac = (uint64_t)input_frac + (uint64_t)step_frac*(uint64_t)(N-1);
+    const uint64_t last_index = input_index + step_index*(uint64_t)(N-1) + (last_frac >> 32);
+    const int nb_input = (int)(last_index - input_index) + 2;
+
+    raw_buffer.resize(nb_input*2);
+    modulator.Generate(raw_buffer, input_index);
+    auto get_sample = [this](const int i) {
+        return std::complex<float>(
+            (float)raw_buffer[2*i+0] - 128.0f,
+            (float)raw_buffer[2*i+1] - 128.0f);
+    };
+
+    // without drift the samples are used as is
+    if ((step_index == 1) && (step_frac == 0)) {
+        for (int i = 0; i < N; i++) {
+            y[i] = get_sample(i);
+        }
+        input_index += (uint64_t)N;
+        return;
+    }
+
+    constexpr float FRAC_SCALE = (float)(1.0/FIXED_POINT_SCALE);
+    uint64_t offset = 0;
+    uint32_t frac = input_frac;
+    for (int i = 0; i < N; i++) {
+        const auto x0 = get_sample((int)offset);
+        const auto x1 = get_sample((int)offset+1);
+        y[i] = x0 + (x1-x0)*((float)frac * FRAC_SCALE);
+        const uint32_t next_frac = frac + step_frac;
+        offset += step_index + ((next_frac < frac) ? 1 : 0);
+        frac = next_frac;
+    }
+    input_index += offset;
+    input_frac = frac;
+}
+
+void ChannelModel::ApplyMultipath(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y) {
+    // y[n] = sum_k h[k]*x[n-k] where x has K-1 samples of history before the block
+    const int K = (int)multipath_taps.size();
+    const int N = (int)y.size();
+    for (int i = 0; i < N; i++) {
+        const std::complex<float>* xn = &x[i+K-1];
+        std::complex<float> acc = 0.0f;
+        for (int k = 0; k < K; k++) {
+            acc += multipath_taps[k] * xn[-k];
+        }
+        y[i] = acc;
+    }
+}
+
+void ChannelModel::ApplyCarrier(tcb::span<std::complex<float>> x) {
+    const int N = (int)x.size();
+    const bool is_phase_noise = phase_noise_scale > 0.0f;
+    if (is_phase_noise) {
+        // real and imaginary parts are independent so each complex sample gives two phase steps
+        noise_buffer.resize((N+1)/2);
+        phase_noise.Generate(noise_buffer, phase_noise_scale);
+    }
+    const float* phase_steps = reinterpret_cast<const float*>(noise_buffer.data());
+    // phase steps are converted through 64bits so only the wrapped phase is kept
+    // steps are clamped to stay inside the range of int64_t
+    constexpr float MAX_PHASE_STEP = 4611686018427387904.0f; // 2^62
+
+    for (int i = 0; i < N; i++) {
+        uint32_t step = carrier_step;
+        if (is_phase_noise) {
+            const float phase_step = std::clamp(phase_steps[i], -MAX_PHASE_STEP, MAX_PHASE_STEP);
+            step += (uint32_t)(int64_t)phase_step;
+        }
+        nco.phase += step;
+        x[i] *= nco.get_output<true>();
+    }
+}
+
+void ChannelModel::ApplyNoise(tcb::span<std::complex<float>> x) {
+    const int N = (int)x.size();
+    noise_buffer.resize(N);
+    noise.Generate(noise_buffer, noise_sigma);
+    for (int i = 0; i < N; i++) {
+        x[i] += noise_buffer[i];
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "utility/span.h"
+#include "dsp/nco.h"
+#include "gaussian_noise.h"
+
+class IQ_Modulator;
+
+// Impairments applied between the transmitter and the rtlsdr
+// IQ_Modulator --> Timing drift --> Multipath --> CFO + phase noise --> AWGN --> 8bit IQ
+struct ChannelSpecification
+{
+    // energy per symbol over noise density in dB, infinity disables the noise
+    float EsN0_dB = INFINITY;
+    // carrier frequency offset in cycles per sample
+    float carrier_offset = 0.0f;
+    // standard deviation of the random walk of the carrier phase in radians per sample
+    float phase_noise = 0.0f;
+    // sample clock of the transmitter relative to the receiver in parts per million
+    // the fractional resampler uses linear interpolation between samples
+    float timing_drift_ppm = 0.0f;
+    // impulse response of the channel in samples, empty for no multipath
+    std::vector<std::complex<float>> multipath;
+    uint64_t seed = 0;
+};
+
+// Stateful channel which pulls the ideal samples from the modulator as needed
+// Consecutive calls to Generate() produce a continuous stream
+class ChannelModel
+{
+private:
+    const ChannelSpecification spec;
+    const IQ_Modulator& modulator;
+    // noise standard deviation of the real and imaginary parts
+    float noise_sigma;
+    GaussianNoiseGenerator noise;
+    // resampler position as an integer sample and a 32bit fixed point fraction
+    uint64_t input_index = 0;
+    uint32_t input_frac = 0;
+    uint64_t step_index = 1;
+    uint32_t step_frac = 0;
+    // carrier as a 32bit fixed point phase which wraps around every cycle
+    NCO nco;
+    uint32_t carrier_step = 0;
+    float phase_noise_scale = 0.0f;
+    GaussianNoiseGenerator phase_noise;
+    // multipath filter taps and the last samples of the previous block
+    std::vector<std::complex<float>> multipath_taps;
+    std::vector<std::complex<float>> multipath_history;
+    // scratch buffers
+    std::vector<uint8_t> raw_buffer;
+    std::vector<std::complex<float>> x_buffer;
+    std::vector<std::complex<float>> y_buffer;
+    std::vector<std::complex<float>> noise_buffer;
+public:
+    ChannelModel(const ChannelSpecification& _spec, const IQ_Modulator& _modulator);
+    ChannelModel(ChannelModel&) = delete;
+    ChannelModel(ChannelModel&&) = delete;
+    ChannelModel& operator=(ChannelModel&) = delete;
+    ChannelModel& operator=(ChannelModel&&) = delete;
+    // iq = 2 bytes per sample
+    void Generate(tcb::span<uint8_t> iq);
+    float GetNoiseSigma() const { return noise_sigma; }
+private:
+    void Resample(tcb::span<std::complex<float>> y);
+    void ApplyMultipath(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y);
+    void ApplyCarrier(tcb::span<std::complex<float>> x);
+    void ApplyNoise(tcb::span<std::complex<float>> x);
+};
@@ -0,0 +1,41 @@
+#include "frame_encoder.h"
+#include <assert.h>
+
+FrameEncoder::FrameEncoder()
+: enc(CONV_POLY),
+  scrambler(SCRAMBLER_CODE, GetEncodedSize(MAX_PAYLOAD_SIZE)-PREAMBLE_SIZE),
+  crc8_calc(CRC8_POLY)
+{}
+
+void FrameEncoder::CreateFrame(tcb::span<const uint8_t> payload, tcb::span<uint8_t> encoded) {
+    const int nb_payload_bytes = (int)payload.size();
+    assert(nb_payload_bytes <= MAX_PAYLOAD_SIZE);
+    assert((int)encoded.size() == GetEncodedSize(nb_payload_bytes));
+
+    for (int i = 0; i < PREAMBLE_SIZE; i++) {
+        encoded[i] = (uint8_t)(PREAMBLE_CODE >> (8*(PREAMBLE_SIZE-1-i)));
+    }
+
+    // convolutional encoding and scrambling are done in the same pass
+    auto frame = encoded.subspan(PREAMBLE_SIZE);
+    int offset = 0;
+    auto push_byte = [this, &frame, &offset](const uint8_t x) {
+        const uint32_t y = enc.consume_byte_packed(x);
+        for (int i = 0; i < CODE_RATE; i++) {
+            frame[offset] = scrambler.process((uint8_t)(y >> (8*(CODE_RATE-1-i))), offset);
+            offset++;
+        }
+    };
+
+    enc.reset();
+    // length is little endian which is how the FrameDecoder reads it
+    const uint16_t length = (uint16_t)nb_payload_bytes;
+    push_byte((uint8_t)(length & 0xFF));
+    push_byte((uint8_t)(length >> 8));
+    for (const uint8_t x: payload) {
+        push_byte(x);
+    }
+    push_byte(crc8_calc.process(payload.data(), nb_payload_bytes));
+    // trellis terminator
+    push_byte(0x00);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include "utility/span.h"
+#include "decoder/convolutional_encoder.h"
+#include "decoder/additive_scrambler.h"
+#include "decoder/crc8.h"
+
+// Encodes a payload into a frame that the FrameDecoder can read
+// 4: preamble
+// additive scrambler + fec of 1/2 K=3 [7,5] code
+// 2: length of payload
+// N: payload
+// 1: CRC8
+// 1: NULL trellis terminator
+// T = 4 + 2*(2+N+1+1) = 2N + 12
+class FrameEncoder
+{
+public:
+    static constexpr int CODE_RATE = 2;
+    static constexpr int CONSTRAINT_LENGTH = 3;
+    static constexpr uint16_t CONV_POLY[CODE_RATE] = { 0b111, 0b101 };
+    // 2x13-barker codes and 1x2-code and 1x4-code to pad preamble bits to be byte aligned
+    static constexpr uint32_t PREAMBLE_CODE = 0b11111001101011111100110101101101;
+    static constexpr uint16_t SCRAMBLER_CODE = 0b1000010101011001;
+    static constexpr uint8_t CRC8_POLY = 0xD5;
+    static constexpr int PREAMBLE_SIZE = 4;
+    static constexpr int MAX_PAYLOAD_SIZE = UINT16_MAX;
+private:
+    ConvolutionalEncoder<CONSTRAINT_LENGTH, CODE_RATE> enc;
+    AdditiveScramblerKeystream scrambler;
+    CRC8_Calculator crc8_calc;
+public:
+    FrameEncoder();
+    static int GetEncodedSize(const int nb_payload_bytes) {
+        return PREAMBLE_SIZE + CODE_RATE*(2 + nb_payload_bytes + 1 + 1);
+    }
+    // encoded = GetEncodedSize(payload.size()) bytes
+    void CreateFrame(tcb::span<const uint8_t> payload, tcb::span<uint8_t> encoded);
+};
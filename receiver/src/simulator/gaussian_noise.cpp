@@ -0,0 +1,120 @@
+#include "gaussian_noise.h"
+#include <assert.h>
+#include "dsp/simd/u32_box_muller.h"
+
+// Each call to generate converts a group of uniform integers at a time
+constexpr int TOTAL_GROUP = 256;
+
+// https://prng.di.unimi.it/splitmix64.c
+static uint64_t splitmix64(uint64_t& x) {
+    x += 0x9E3779B97F4A7C15ull;
+    uint64_t z = x;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl(const uint32_t x, const int k) {
+    return (x << k) | (x >> (32-k));
+}
+
+GaussianNoiseGenerator::GaussianNoiseGenerator(const uint64_t seed) {
+    Seed(seed);
+}
+
+void GaussianNoiseGenerator::Seed(const uint64_t seed) {
+    // xoshiro128+ must not be seeded with all zeros which splitmix64 avoids
+    uint64_t x = seed;
+    for (int i = 0; i < 4*TOTAL_LANES; i += 2) {
+        const uint64_t v = splitmix64(x);
+        state[i]   = (uint32_t)(v & 0xFFFFFFFF);
+        state[i+1] = (uint32_t)(v >> 32);
+    }
+}
+
+// https://prng.di.unimi.it/xoshiro128plus.c
+// Lanes are updated together so N must be a multiple of TOTAL_LANES
+static inline void xoshiro128plus_scalar(uint32_t* s, uint32_t* y, const int N) {
+    constexpr int L = GaussianNoiseGenerator::TOTAL_LANES;
+    for (int i = 0; i < N; i += L) {
+        for (int j = 0; j < L; j++) {
+            uint32_t* s0 = &s[0*L+j];
+            uint32_t* s1 = &s[1*L+j];
+            uint32_t* s2 = &s[2*L+j];
+            uint32_t* s3 = &s[3*L+j];
+            y[i+j] = *s0 + *s3;
+            const uint32_t t = *s1 << 9;
+            *s2 ^= *s0;
+            *s3 ^= *s1;
+            *s1 ^= *s2;
+            *s0 ^= *s3;
+            *s2 ^= t;
+            *s3 = rotl(*s3, 11);
+        }
+    }
+}
+
+#if defined(_DSP_BUILD_AVX2)
+DSP_TARGET_AVX2_BEGIN
+static inline void xoshiro128plus_avx2(uint32_t* s, uint32_t* y, const int N) {
+    constexpr int L = GaussianNoiseGenerator::TOTAL_LANES;
+    static_assert(L == 8, "AVX2 updates 8 lanes of 32bits at once");
+    __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[0*L]));
+    __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[1*L]));
+    __m256i s2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[2*L]));
+    __m256i s3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[3*L]));
+    for (int i = 0; i < N; i += L) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[i]), _mm256_add_epi32(s0, s3));
+        const __m256i t = _mm256_slli_epi32(s1, 9);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 32-11));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[0*L]), s0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[1*L]), s1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[2*L]), s2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&s[3*L]), s3);
+}
+DSP_TARGET_END
+#endif
+
+static void xoshiro128plus_auto(uint32_t* s, uint32_t* y, const int N) {
+    assert((N % GaussianNoiseGenerator::TOTAL_LANES) == 0);
+    #if defined(_DSP_DISPATCH)
+    static const auto func = dsp_select_kernel(
+        &xoshiro128plus_scalar, &xoshiro128plus_scalar, &xoshiro128plus_avx2);
+    func(s, y, N);
+    #elif defined(_DSP_AVX2)
+    xoshiro128plus_avx2(s, y, N);
+    #else
+    xoshiro128plus_scalar(s, y, N);
+    #endif
+}
+
+void GaussianNoiseGenerator::GenerateUniform(tcb::span<uint32_t> y) {
+    const int N = (int)y.size();
+    const int N_group = (N/TOTAL_LANES)*TOTAL_LANES;
+    xoshiro128plus_auto(state, y.data(), N_group);
+    if (N_group < N) {
+        uint32_t tail[TOTAL_LANES];
+        xoshiro128plus_auto(state, tail, TOTAL_LANES);
+        for (int i = N_group; i < N; i++) {
+            y[i] = tail[i-N_group];
+        }
+    }
+}
+
+void GaussianNoiseGenerator::Generate(tcb::span<std::complex<float>> y, const float sigma) {
+    uint32_t u0[TOTAL_GROUP];
+    uint32_t u1[TOTAL_GROUP];
+    const int N = (int)y.size();
+    for (int i = 0; i < N; i += TOTAL_GROUP) {
+        const int M = ((N-i) < TOTAL_GROUP) ? (N-i) : TOTAL_GROUP;
+        GenerateUniform({ u0, (size_t)M });
+        GenerateUniform({ u1, (size_t)M });
+        u32_box_muller_auto(u0, u1, &y[i], M, sigma);
+    }
+}
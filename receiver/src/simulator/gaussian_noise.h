@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <complex>
+#include "utility/span.h"
+
+// Seeded complex gaussian noise generator
+// Uniform integers come from 8 interleaved xoshiro128+ generators so they can be updated as one vector
+// These are converted to gaussian noise with the Box-Muller transform
+// NOTE: The same seed gives the same uniform integers with or without SIMD
+class GaussianNoiseGenerator
+{
+public:
+    static constexpr int TOTAL_LANES = 8;
+private:
+    // state[i*TOTAL_LANES + lane] = word i of xoshiro128+ for that lane
+    uint32_t state[4*TOTAL_LANES];
+public:
+    GaussianNoiseGenerator(const uint64_t seed=0);
+    void Seed(const uint64_t seed);
+    // y = complex noise where the real and imaginary parts each have a standard deviation of sigma
+    void Generate(tcb::span<std::complex<float>> y, const float sigma);
+    // y = uniform random integers
+    void GenerateUniform(tcb::span<uint32_t> y);
+};
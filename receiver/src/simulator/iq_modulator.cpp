@@ -0,0 +1,142 @@
+#include "iq_modulator.h"
+#include <assert.h>
+#include <algorithm>
+#include "dsp/simd/u16_repeat.h"
+
+static uint16_t pack_iq(const uint8_t I, const uint8_t Q) {
+    return (uint16_t)((uint16_t)I | ((uint16_t)Q << 8));
+}
+
+IQ_Modulator::IQ_Modulator(const ModulationType _modulation, const int _samples_per_symbol)
+: modulation(_modulation), samples_per_symbol(_samples_per_symbol)
+{
+    assert(samples_per_symbol > 0);
+    CreateTable();
+}
+
+void IQ_Modulator::CreateTable() {
+    const int A = 64;
+    const int B = 128;
+
+    switch (modulation) {
+    case ModulationType::QAM16:
+        {
+            // 2 symbols per byte as [I1 Q1 I2 Q2] from msb to lsb
+            const uint8_t gray_code[4] = {0b00, 0b01, 0b11, 0b10};
+            // Average of QAM signal is 1.5 = (0+1+2+3)/4 = 6/4 = 3/2
+            const int DC = (int)((float)A * 1.5f);
+            auto get_val = [&gray_code, A, B, DC](const int v) {
+                return (uint8_t)((int)gray_code[v]*A + B - DC);
+            };
+            symbols_per_byte = 2;
+            byte_symbols.resize(256*symbols_per_byte);
+            for (int x = 0; x < 256; x++) {
+                for (int i = 0; i < symbols_per_byte; i++) {
+                    const int shift = 6-4*i;
+                    const int I = (x >> shift) & 0b11;
+                    const int Q = (x >> (shift-2)) & 0b11;
+                    byte_symbols[x*symbols_per_byte + i] = pack_iq(get_val(I), get_val(Q));
+                }
+            }
+        }
+        break;
+    case ModulationType::QPSK:
+    default:
+        {
+            // 4 symbols per byte as [I1 Q1 I2 Q2 I3 Q3 I4 Q4] from msb to lsb
+            // NOTE: 4QAM is already gray code by itself
+            // Average amplitude is 0.5 = (0+1)/2 = 0.5
+            const int DC = A/2;
+            auto get_val = [A, B, DC](const int v) {
+                return (uint8_t)(v*A + B - DC);
+            };
+            symbols_per_byte = 4;
+            byte_symbols.resize(256*symbols_per_byte);
+            for (int x = 0; x < 256; x++) {
+                for (int i = 0; i < symbols_per_byte; i++) {
+                    const int shift = 7-2*i;
+                    const int I = (x >> shift) & 0b1;
+                    const int Q = (x >> (shift-1)) & 0b1;
+                    byte_symbols[x*symbols_per_byte + i] = pack_iq(get_val(I), get_val(Q));
+                }
+            }
+        }
+        break;
+    }
+}
+
+void IQ_Modulator::SetData(tcb::span<const uint8_t> encoded_bytes) {
+    data.resize(encoded_bytes.size());
+    std::copy_n(encoded_bytes.begin(), encoded_bytes.size(), data.begin());
+}
+
+uint64_t IQ_Modulator::GetTotalSamples() const {
+    return (uint64_t)data.size() * (uint64_t)symbols_per_byte * (uint64_t)samples_per_symbol;
+}
+
+float IQ_Modulator::GetSymbolPower() const {
+    // each byte is equally likely after scrambling
+    double total = 0.0;
+    for (const uint16_t v: byte_symbols) {
+        const double I = (double)(v & 0xFF) - 128.0;
+        const double Q = (double)(v >> 8) - 128.0;
+        total += I*I + Q*Q;
+    }
+    return (float)(total / (double)byte_symbols.size());
+}
+
+void IQ_Modulator::Generate(tcb::span<uint8_t> iq, const uint64_t sample_offset) const {
+    assert((iq.size() % 2) == 0);
+    assert(!data.empty());
+
+    // NOTE: IQ pairs are written as (Q << 8) | I which assumes little endian
+    uint16_t* y = reinterpret_cast<uint16_t*>(iq.data());
+    const int N = (int)(iq.size()/2);
+
+    const uint64_t total_symbols = (uint64_t)data.size() * (uint64_t)symbols_per_byte;
+    const uint64_t start_symbol = (sample_offset / (uint64_t)samples_per_symbol) % total_symbols;
+    int curr_byte = (int)(start_symbol / (uint64_t)symbols_per_byte);
+    int curr_byte_symbol = (int)(start_symbol % (uint64_t)symbols_per_byte);
+    int curr_repeat = (int)(sample_offset % (uint64_t)samples_per_symbol);
+
+    auto get_next_symbol = [this, &curr_byte, &curr_byte_symbol]() {
+        const uint16_t v = byte_symbols[data[curr_byte]*symbols_per_byte + curr_byte_symbol];
+        curr_byte_symbol++;
+        if (curr_byte_symbol == symbols_per_byte) {
+            curr_byte_symbol = 0;
+            curr_byte++;
+            curr_byte = (curr_byte == (int)data.size()) ? 0 : curr_byte;
+        }
+        return v;
+    };
+
+    int i = 0;
+    // finish the symbol that was split across the previous block
+    if (curr_repeat != 0) {
+        const uint16_t v = get_next_symbol();
+        for (; (i < N) && (curr_repeat < samples_per_symbol); i++, curr_repeat++) {
+            y[i] = v;
+        }
+    }
+
+    // map a group of whole symbols then repeat them into the output
+    constexpr int MAX_SYMBOLS = 256;
+    uint16_t symbols[MAX_SYMBOLS];
+    while ((N-i) >= samples_per_symbol) {
+        int nb_symbols = (N-i)/samples_per_symbol;
+        nb_symbols = (nb_symbols > MAX_SYMBOLS) ? MAX_SYMBOLS : nb_symbols;
+        for (int j = 0; j < nb_symbols; j++) {
+            symbols[j] = get_next_symbol();
+        }
+        u16_repeat_auto(symbols, &y[i], nb_symbols, samples_per_symbol);
+        i += nb_symbols*samples_per_symbol;
+    }
+
+    // start of the symbol that is split across the next block
+    if (i < N) {
+        const uint16_t v = get_next_symbol();
+        for (; i < N; i++) {
+            y[i] = v;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "utility/span.h"
+
+enum class ModulationType { QAM16, QPSK };
+
+// Maps encoded bytes to IQ symbols and repeats each symbol for the samples per symbol
+// Output samples are interleaved unsigned 8bit IQ like the rtlsdr
+// The encoded bytes are looped forever so the output is indexed by the absolute sample
+// This means any range of samples can be generated without the previous ones
+class IQ_Modulator
+{
+private:
+    const ModulationType modulation;
+    const int samples_per_symbol;
+    int symbols_per_byte;
+    // byte_symbols[byte*symbols_per_byte + i] = symbol i of byte packed as (Q << 8) | I
+    std::vector<uint16_t> byte_symbols;
+    std::vector<uint8_t> data;
+public:
+    IQ_Modulator(const ModulationType _modulation, const int _samples_per_symbol);
+    void SetData(tcb::span<const uint8_t> encoded_bytes);
+    // number of samples before the output repeats
+    uint64_t GetTotalSamples() const;
+    int GetSamplesPerSymbol() const { return samples_per_symbol; }
+    // average power of the symbols with the dc offset removed
+    float GetSymbolPower() const;
+    // iq = 2 bytes per sample starting at sample_offset
+    void Generate(tcb::span<uint8_t> iq, const uint64_t sample_offset) const;
+private:
+    void CreateTable();
+};
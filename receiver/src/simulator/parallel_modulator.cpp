@@ -0,0 +1,83 @@
+#include "parallel_modulator.h"
+#include "iq_modulator.h"
+#include <assert.h>
+
+ParallelModulator::ParallelModulator(const IQ_Modulator& _modulator, const int nb_threads)
+: modulator(_modulator),
+  total_workers(get_total_workers(nb_threads))
+{
+    for (int i = 0; i < total_workers; i++) {
+        workers.emplace_back([this, i]() { RunWorker(i); });
+    }
+}
+
+int ParallelModulator::get_total_workers(const int nb_threads) {
+    if (nb_threads > 0) {
+        return nb_threads;
+    }
+    const int nb_hardware = (int)std::thread::hardware_concurrency();
+    return (nb_hardware > 0) ? nb_hardware : 1;
+}
+
+ParallelModulator::~ParallelModulator() {
+    {
+        auto lock = std::scoped_lock(mutex_job);
+        is_stop = true;
+    }
+    cv_start.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+void ParallelModulator::Start(tcb::span<uint8_t> iq, const uint64_t sample_offset) {
+    assert((iq.size() % 2) == 0);
+    {
+        auto lock = std::scoped_lock(mutex_job);
+        assert(nb_pending == 0);
+        job_iq = iq;
+        job_sample_offset = sample_offset;
+        job_id++;
+        nb_pending = total_workers;
+    }
+    cv_start.notify_all();
+}
+
+void ParallelModulator::Wait() {
+    auto lock = std::unique_lock(mutex_job);
+    cv_done.wait(lock, [this]() { return nb_pending == 0; });
+}
+
+void ParallelModulator::RunWorker(const int index) {
+    uint64_t prev_job_id = 0;
+    while (true) {
+        tcb::span<uint8_t> iq;
+        uint64_t sample_offset = 0;
+        {
+            auto lock = std::unique_lock(mutex_job);
+            cv_start.wait(lock, [this, prev_job_id]() { return is_stop || (job_id != prev_job_id); });
+            if (is_stop) {
+                return;
+            }
+            prev_job_id = job_id;
+            iq = job_iq;
+            sample_offset = job_sample_offset;
+        }
+
+        // contiguous slice of samples for this worker
+        const size_t nb_samples = iq.size()/2;
+        const size_t start = nb_samples * (size_t)index / (size_t)total_workers;
+        const size_t end = nb_samples * (size_t)(index+1) / (size_t)total_workers;
+        if (end > start) {
+            modulator.Generate(iq.subspan(start*2, (end-start)*2), sample_offset + (uint64_t)start);
+        }
+
+        {
+            auto lock = std::scoped_lock(mutex_job);
+            nb_pending--;
+            if (nb_pending == 0) {
+                cv_done.notify_all();
+            }
+        }
+    }
+}
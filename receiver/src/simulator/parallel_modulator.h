@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "utility/span.h"
+
+class IQ_Modulator;
+
+// Splits the generation of a large range of IQ samples across a pool of worker threads
+// Since IQ_Modulator is indexed by the absolute sample, each worker generates its slice independently
+// Start() returns immediately so the caller can write out the previous range while this one is generated
+class ParallelModulator
+{
+private:
+    const IQ_Modulator& modulator;
+    const int total_workers;
+    std::vector<std::thread> workers;
+    std::mutex mutex_job;
+    std::condition_variable cv_start;
+    std::condition_variable cv_done;
+    // current job
+    tcb::span<uint8_t> job_iq;
+    uint64_t job_sample_offset = 0;
+    uint64_t job_id = 0;
+    int nb_pending = 0;
+    bool is_stop = false;
+public:
+    // nb_threads = number of workers, 0 uses the number of hardware threads
+    ParallelModulator(const IQ_Modulator& _modulator, const int nb_threads=0);
+    ~ParallelModulator();
+    ParallelModulator(ParallelModulator&) = delete;
+    ParallelModulator(ParallelModulator&&) = delete;
+    ParallelModulator& operator=(ParallelModulator&) = delete;
+    ParallelModulator& operator=(ParallelModulator&&) = delete;
+    // Start generating iq from sample_offset, iq must stay valid until Wait() returns
+    // NOTE: Only one range can be generated at a time
+    void Start(tcb::span<uint8_t> iq, const uint64_t sample_offset);
+    void Wait();
+    int GetTotalThreads() const { return total_workers; }
+private:
+    static int get_total_workers(const int nb_threads);
+    void RunWorker(const int index);
+};
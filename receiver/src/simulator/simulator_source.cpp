@@ -0,0 +1,35 @@
+#include "simulator_source.h"
+#include "iq_modulator.h"
+#include "channel_model.h"
+
+SimulatorSampleSource::SimulatorSampleSource(const IQ_Modulator& _modulator, const uint64_t _total_samples)
+: modulator(&_modulator), channel(NULL), total_samples(_total_samples) {}
+
+SimulatorSampleSource::SimulatorSampleSource(ChannelModel& _channel, const uint64_t _total_samples)
+: modulator(NULL), channel(&_channel), total_samples(_total_samples) {}
+
+size_t SimulatorSampleSource::Read(tcb::span<std::complex<uint8_t>> x) {
+    size_t N = x.size();
+    if (total_samples > 0) {
+        const uint64_t nb_remain = (curr_sample < total_samples) ? (total_samples - curr_sample) : 0;
+        N = (nb_remain < (uint64_t)N) ? (size_t)nb_remain : N;
+    }
+
+    // complex<uint8_t> is stored as interleaved IQ bytes
+    auto iq = tcb::span(reinterpret_cast<uint8_t*>(x.data()), N*2);
+    if (channel) {
+        channel->Generate(iq);
+    } else {
+        modulator->Generate(iq, curr_sample);
+    }
+    curr_sample += (uint64_t)N;
+    return N;
+}
+
+bool SimulatorSampleSource::Rewind() {
+    if (channel) {
+        return false;
+    }
+    curr_sample = 0;
+    return true;
+}
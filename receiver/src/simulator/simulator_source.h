@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <complex>
+#include "utility/span.h"
+#include "utility/sample_source.h"
+
+class IQ_Modulator;
+class ChannelModel;
+
+// Generates the transmitter output in process so the receiver can run without a pipe
+// Samples are written directly into the block being read, usually QAM_Synchroniser_Buffer::x_raw
+// Samples come from the modulator or from a channel model which is wrapped around it
+class SimulatorSampleSource: public SampleSource
+{
+private:
+    const IQ_Modulator* modulator;
+    ChannelModel* channel;
+    // 0 for an endless stream
+    const uint64_t total_samples;
+    uint64_t curr_sample = 0;
+public:
+    SimulatorSampleSource(const IQ_Modulator& _modulator, const uint64_t _total_samples=0);
+    SimulatorSampleSource(ChannelModel& _channel, const uint64_t _total_samples=0);
+    size_t Read(tcb::span<std::complex<uint8_t>> x) override;
+    // NOTE: The channel model cannot go back to a previous state so it can't be rewound
+    bool Rewind() override;
+    uint64_t GetCurrentSample() const { return curr_sample; }
+};
@@ -0,0 +1,373 @@
+// Sweep the packet error rate of the link over a range of signal to noise ratios
+// Each point runs the transmitter, channel and receiver in process without any pipes
+// FrameEncoder --> IQ_Modulator --> ChannelModel --> SimulatorSampleSource --> App
+// Points are independent so they are spread across all cores
+// Writes a csv row for each point with the packet error rate, repaired frame rate and throughput
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "app.h"
+#include "simulator/frame_encoder.h"
+#include "simulator/iq_modulator.h"
+#include "simulator/channel_model.h"
+#include "simulator/gaussian_noise.h"
+#include "simulator/simulator_source.h"
+#include "utility/getopt/getopt.h"
+#include "utility/span.h"
+
+void usage() {
+    fprintf(stderr,
+        "sweep_link, measures the packet error rate of the 16QAM link against Es/N0\n\n"
+        "\t[-l lowest Es/N0 in dB (default: 10)]\n"
+        "\t[-u highest Es/N0 in dB (default: 30)]\n"
+        "\t[-i Es/N0 step in dB (default: 1)]\n"
+        "\t[-n number of frames for each point (default: 1000)]\n"
+        "\t[-p payload size of each frame (default: 64)]\n"
+        "\t[-f sample rate (default: 1MHz)]\n"
+        "\t[-s symbol rate (default: 200kHz)]\n"
+        "\t[-b block size (default: 8192)]\n"
+        "\t[-D downsample factor (default: 2)]\n"
+        "\t[-S upsample factor (default: 4)]\n"
+        "\t[-c carrier frequency offset in Hz (default: 0)]\n"
+        "\t[-d sample clock drift in ppm (default: 0)]\n"
+        "\t[-w time for the receiver to settle before the first frame (default: 0.5s)]\n"
+        "\t[-r seed for the payloads and noise (default: 0)]\n"
+        "\t[-j number of threads (default: all)]\n"
+        "\t[-V decode frames in batches with the SIMD viterbi decoder (default: false)]\n"
+        "\t[-o output csv filename (default: stdout)]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+struct SweepSettings {
+    int nb_frames = 1000;
+    int nb_payload_bytes = 64;
+    float Fsample = 1e6;
+    float Fsymbol = 200e3;
+    int block_size = 8192;
+    int ds_factor = 2;
+    int us_factor = 4;
+    float carrier_offset = 0.0f;
+    float timing_drift_ppm = 0.0f;
+    float settling_time = 0.5f;
+    uint64_t seed = 0;
+    bool is_batch_viterbi = false;
+};
+
+struct SweepResult {
+    float EsN0_dB = 0.0f;
+    int frames_sent = 0;
+    // stats from the frame handler
+    int total = 0;
+    int correct = 0;
+    int incorrect = 0;
+    int corrupted = 0;
+    int repaired = 0;
+    uint64_t total_samples = 0;
+    double samples_per_second = 0.0;
+    // frames which were not received correctly including ones where the preamble was missed
+    double GetPacketErrorRate() const {
+        return (double)(frames_sent - std::min(correct, frames_sent)) / (double)frames_sent;
+    }
+    double GetRepairedRate() const {
+        return (correct > 0) ? (double)repaired / (double)correct : 0.0;
+    }
+};
+
+QAM_Synchroniser_Specification create_qam_sync_spec(const SweepSettings& settings);
+SweepResult run_point(const SweepSettings& settings, const float EsN0_dB);
+
+int main(int argc, char** argv) {
+    auto settings = SweepSettings();
+    float EsN0_lower = 10.0f;
+    float EsN0_upper = 30.0f;
+    float EsN0_step = 1.0f;
+    int nb_threads = 0;
+    const char* filename = NULL;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "l:u:i:n:p:f:s:b:D:S:c:d:w:r:j:Vo:h")) != -1) {
+        switch (opt) {
+        case 'l':
+            EsN0_lower = (float)(atof(optarg));
+            break;
+        case 'u':
+            EsN0_upper = (float)(atof(optarg));
+            break;
+        case 'i':
+            EsN0_step = (float)(atof(optarg));
+            if (EsN0_step <= 0.0f) {
+                fprintf(stderr, "Es/N0 step must be positive (%.2f)\n", EsN0_step);
+                return 1;
+            }
+            break;
+        case 'n':
+            settings.nb_frames = (int)(atof(optarg));
+            if (settings.nb_frames <= 0) {
+                fprintf(stderr, "Number of frames must be positive (%d)\n", settings.nb_frames);
+                return 1;
+            }
+            break;
+        case 'p':
+            settings.nb_payload_bytes = (int)(atof(optarg));
+            if ((settings.nb_payload_bytes <= 0) || (settings.nb_payload_bytes > FrameEncoder::MAX_PAYLOAD_SIZE)) {
+                fprintf(stderr, "Payload size must be between 1 and %d (%d)\n", FrameEncoder::MAX_PAYLOAD_SIZE, settings.nb_payload_bytes);
+                return 1;
+            }
+            break;
+        case 'f':
+            settings.Fsample = (float)(atof(optarg));
+            if (settings.Fsample <= 0) {
+                fprintf(stderr, "Sampling rate must be positive (%.2f)\n", settings.Fsample);
+                return 1;
+            }
+            break;
+        case 's':
+            settings.Fsymbol = (float)(atof(optarg));
+            if (settings.Fsymbol <= 0) {
+                fprintf(stderr, "Symbol rate must be positive (%.2f)\n", settings.Fsymbol);
+                return 1;
+            }
+            break;
+        case 'b':
+            settings.block_size = (int)(atof(optarg));
+            if (settings.block_size <= 0) {
+                fprintf(stderr, "Block size must be positive (%d)\n", settings.block_size);
+                return 1;
+            }
+            break;
+        case 'D':
+            settings.ds_factor = (int)(atof(optarg));
+            if (settings.ds_factor <= 0) {
+                fprintf(stderr, "Downsampling factor must be positive (%d)\n", settings.ds_factor);
+                return 1;
+            }
+            break;
+        case 'S':
+            settings.us_factor = (int)(atof(optarg));
+            if (settings.us_factor <= 0) {
+                fprintf(stderr, "Upsampling factor must be positive (%d)\n", settings.us_factor);
+                return 1;
+            }
+            break;
+        case 'c':
+            settings.carrier_offset = (float)(atof(optarg));
+            break;
+        case 'd':
+            settings.timing_drift_ppm = (float)(atof(optarg));
+            break;
+        case 'w':
+            settings.settling_time = (float)(atof(optarg));
+            if (settings.settling_time < 0.0f) {
+                fprintf(stderr, "Settling time cannot be negative (%.2f)\n", settings.settling_time);
+                return 1;
+            }
+            break;
+        case 'r':
+            settings.seed = (uint64_t)(atof(optarg));
+            break;
+        case 'j':
+            nb_threads = (int)(atof(optarg));
+            break;
+        case 'V':
+            settings.is_batch_viterbi = true;
+            break;
+        case 'o':
+            filename = optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    if (EsN0_upper < EsN0_lower) {
+        fprintf(stderr, "Highest Es/N0 must be above the lowest (%.2f < %.2f)\n", EsN0_upper, EsN0_lower);
+        return 1;
+    }
+
+    const float Nsamples = settings.Fsample / settings.Fsymbol;
+    if (std::abs(Nsamples - std::round(Nsamples)) > 1e-3f) {
+        fprintf(stderr, "Sample rate must be a multiple of the symbol rate (%.2f)\n", Nsamples);
+        return 1;
+    }
+
+    auto EsN0_points = std::vector<float>();
+    const int nb_points = (int)std::floor((EsN0_upper-EsN0_lower)/EsN0_step + 1e-3f) + 1;
+    for (int i = 0; i < nb_points; i++) {
+        EsN0_points.push_back(EsN0_lower + EsN0_step*(float)i);
+    }
+
+    FILE* fp_out = stdout;
+    if (filename != NULL) {
+        fp_out = fopen(filename, "w");
+        if (fp_out == nullptr) {
+            fprintf(stderr, "Failed to open file: %s\n", filename);
+            return 1;
+        }
+    }
+
+    if (nb_threads <= 0) {
+        nb_threads = (int)std::thread::hardware_concurrency();
+    }
+    nb_threads = std::max(1, std::min(nb_threads, nb_points));
+
+    // Each thread takes the next point until they are all done
+    auto results = std::vector<SweepResult>(nb_points);
+    auto next_point = std::atomic<int>(0);
+    auto workers = std::vector<std::thread>();
+    const auto dt_start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < nb_threads; i++) {
+        workers.emplace_back([&]() {
+            while (true) {
+                const int point = next_point.fetch_add(1);
+                if (point >= nb_points) {
+                    break;
+                }
+                results[point] = run_point(settings, EsN0_points[point]);
+                const auto& res = results[point];
+                fprintf(stderr, "Es/N0=%.2fdB PER=%.3e repaired=%.3e %.2f MS/s\n",
+                    res.EsN0_dB, res.GetPacketErrorRate(), res.GetRepairedRate(), res.samples_per_second*1e-6);
+            }
+        });
+    }
+    for (auto& worker: workers) {
+        worker.join();
+    }
+    const auto dt_end = std::chrono::high_resolution_clock::now();
+    const double dt = std::chrono::duration<double>(dt_end-dt_start).count();
+
+    fprintf(fp_out, "esn0_db,frames_sent,frames_received,correct,incorrect,corrupted,repaired,packet_error_rate,repaired_rate,samples,samples_per_second\n");
+    for (const auto& res: results) {
+        fprintf(fp_out, "%.2f,%d,%d,%d,%d,%d,%d,%.6e,%.6e,%llu,%.0f\n",
+            res.EsN0_dB, res.frames_sent, res.total,
+            res.correct, res.incorrect, res.corrupted, res.repaired,
+            res.GetPacketErrorRate(), res.GetRepairedRate(),
+            (unsigned long long)res.total_samples, res.samples_per_second);
+    }
+    fprintf(stderr, "Swept %d points using %d threads in %.2fs\n", nb_points, nb_threads, dt);
+
+    if (fp_out != stdout) {
+        fclose(fp_out);
+    }
+    return 0;
+}
+
+// Same settings as read_data
+QAM_Synchroniser_Specification create_qam_sync_spec(const SweepSettings& settings) {
+    const float PI = 3.1415f;
+    auto spec = QAM_Synchroniser_Specification();
+    spec.f_sample = settings.Fsample;
+    spec.f_symbol = settings.Fsymbol;
+
+    spec.downsampling_filter.M = settings.ds_factor;
+    spec.downsampling_filter.K = 6;
+
+    spec.upsampling_filter.L = settings.us_factor;
+    spec.upsampling_filter.K = 6;
+
+    spec.ac_filter.k = 0.99999f;
+    spec.agc.beta = 0.2f;
+    spec.agc.initial_gain = 0.1f;
+    spec.carrier_pll.f_center = 0e3;
+    spec.carrier_pll.f_gain = 2.5e3;
+    spec.carrier_pll.phase_error_gain = 8.0f/PI;
+    spec.carrier_pll_filter.butterworth_cutoff = 5e3;
+    spec.carrier_pll_filter.integrator_gain = 1000.0f;
+    spec.ted_pll.f_gain = 30e3;
+    spec.ted_pll.f_offset = 0e3;
+    spec.ted_pll.phase_error_gain = 1.0f;
+    spec.ted_pll_filter.butterworth_cutoff = 60e3;
+    spec.ted_pll_filter.integrator_gain = 250.0f;
+    return spec;
+}
+
+// Stream layout is [settling][frame 0]...[frame N-1][padding]
+// The settling symbols give the ac filter, agc and loops time to lock before the first frame
+// The padding flushes the last frame through the filters
+// It is longer than a receiver block so rounding up to whole blocks never wraps around into the frames
+SweepResult run_point(const SweepSettings& settings, const float EsN0_dB) {
+    const int samples_per_symbol = (int)std::round(settings.Fsample / settings.Fsymbol);
+    const int samples_per_byte = samples_per_symbol * 2;
+    const int src_block_size = settings.block_size * settings.ds_factor;
+    const int nb_padding_bytes = src_block_size / samples_per_byte + 64;
+    const int nb_settling_bytes = (int)(settings.settling_time * settings.Fsample) / samples_per_byte + 64;
+    const int nb_encoded_bytes = FrameEncoder::GetEncodedSize(settings.nb_payload_bytes);
+
+    // transmitter
+    // padding is random symbols since a constant symbol is removed by the ac filter and the loops would not lock
+    const int nb_data_bytes = nb_settling_bytes + settings.nb_frames*nb_encoded_bytes + nb_padding_bytes;
+    auto data_words = std::vector<uint32_t>((nb_data_bytes+3)/4);
+    auto data = tcb::span(reinterpret_cast<uint8_t*>(data_words.data()), (size_t)nb_data_bytes);
+    {
+        auto rng = GaussianNoiseGenerator(settings.seed);
+        rng.GenerateUniform(data_words);
+        auto payload_words = std::vector<uint32_t>((settings.nb_payload_bytes+3)/4);
+        auto payload = tcb::span(reinterpret_cast<uint8_t*>(payload_words.data()), (size_t)settings.nb_payload_bytes);
+        auto encoder = FrameEncoder();
+        auto frames = tcb::span(data).subspan(nb_settling_bytes, (size_t)(settings.nb_frames*nb_encoded_bytes));
+        for (int i = 0; i < settings.nb_frames; i++) {
+            rng.GenerateUniform(payload_words);
+            encoder.CreateFrame(payload, frames.subspan(i*nb_encoded_bytes, nb_encoded_bytes));
+        }
+    }
+
+    auto modulator = IQ_Modulator(ModulationType::QAM16, samples_per_symbol);
+    modulator.SetData(data);
+
+    auto channel_spec = ChannelSpecification();
+    channel_spec.EsN0_dB = EsN0_dB;
+    channel_spec.carrier_offset = settings.carrier_offset / settings.Fsample;
+    channel_spec.timing_drift_ppm = settings.timing_drift_ppm;
+    // each point gets different noise
+    channel_spec.seed = settings.seed + (uint64_t)std::llround(EsN0_dB*1000.0f) + 1;
+    auto channel = ChannelModel(channel_spec, modulator);
+
+    const uint64_t total_samples = modulator.GetTotalSamples();
+    const int total_blocks = (int)((total_samples + (uint64_t)src_block_size - 1) / (uint64_t)src_block_size);
+    assert((uint64_t)total_blocks*(uint64_t)src_block_size - total_samples < (uint64_t)(nb_padding_bytes*samples_per_byte));
+    auto rx_source = SimulatorSampleSource(channel, (uint64_t)total_blocks*(uint64_t)src_block_size);
+
+    // receiver
+    const int decoder_block_size = 1024;
+    const float Faudio = settings.Fsymbol/5.0f;
+    const bool is_diagnostics = false;
+    auto app = App(
+        rx_source, settings.block_size,
+        decoder_block_size, settings.ds_factor, settings.us_factor,
+        (int)Faudio, Faudio,
+        is_diagnostics);
+    app.qam_sync_spec = create_qam_sync_spec(settings);
+    app.GetFrameHandler().is_output_audio = false;
+    app.GetFrameDecoder().SetBatchViterbi(settings.is_batch_viterbi);
+    app.BuildDemodulator();
+
+    const auto dt_start = std::chrono::high_resolution_clock::now();
+    app.Run();
+    const auto dt_end = std::chrono::high_resolution_clock::now();
+    const double dt = std::chrono::duration<double>(dt_end-dt_start).count();
+
+    auto res = SweepResult();
+    const auto& stats = app.GetFrameHandler().stats;
+    res.EsN0_dB = EsN0_dB;
+    res.frames_sent = settings.nb_frames;
+    res.total = stats.total;
+    res.correct = stats.correct;
+    res.incorrect = stats.incorrect;
+    res.corrupted = stats.corrupted;
+    res.repaired = stats.repaired;
+    res.total_samples = rx_source.GetCurrentSample();
+    res.samples_per_second = (double)res.total_samples / dt;
+    return res;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <complex>
+#include "span.h"
+
+// Provides blocks of raw 8bit IQ samples to the receiver
+// Samples are written straight into the receiver's input buffer so there is no intermediate copy
+class SampleSource
+{
+public:
+    virtual ~SampleSource() {}
+    // Returns the number of samples written which is less than x.size() at the end of the stream
+    virtual size_t Read(tcb::span<std::complex<uint8_t>> x) = 0;
+    // Restart the stream from the beginning, returns false if this isn't possible
+    virtual bool Rewind() = 0;
+};
+
+// Reads samples from a file or a pipe like stdin
+class FileSampleSource: public SampleSource
+{
+private:
+    FILE* fp;
+public:
+    FileSampleSource(FILE* _fp): fp(_fp) {}
+    size_t Read(tcb::span<std::complex<uint8_t>> x) override {
+        return fread(x.data(), sizeof(std::complex<uint8_t>), x.size(), fp);
+    }
+    bool Rewind() override {
+        return fseek(fp, 0, SEEK_SET) == 0;
+    }
+};
+
+// Reads samples from memory, e.g. a stream which was generated beforehand
+class MemorySampleSource: public SampleSource
+{
+private:
+    tcb::span<const std::complex<uint8_t>> samples;
+    size_t curr_sample = 0;
+public:
+    MemorySampleSource(tcb::span<const std::complex<uint8_t>> _samples): samples(_samples) {}
+    size_t Read(tcb::span<std::complex<uint8_t>> x) override {
+        const size_t nb_remain = samples.size() - curr_sample;
+        const size_t N = (x.size() < nb_remain) ? x.size() : nb_remain;
+        memcpy(x.data(), samples.data() + curr_sample, N*sizeof(std::complex<uint8_t>));
+        curr_sample += N;
+        return N;
+    }
+    bool Rewind() override {
+        curr_sample = 0;
+        return true;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+// Bounded lock free queue for passing items from one producer thread to one consumer thread
+// Push() and Pop() sleep when the queue is full or empty instead of spinning
+// The mutex is only taken by a thread which has to wait or when there is a waiting thread to wake up
+// NOTE: Only a single thread may push and only a single thread may pop
+template <typename T>
+class SPSC_Queue
+{
+private:
+    // Keep read and write indices on separate cache lines to avoid false sharing
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    // One slot is left empty to distinguish between a full and empty queue
+    const size_t length;
+    std::vector<T> buf;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> wr_index;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> rd_index;
+    // Set by a thread before it sleeps so the other thread knows to wake it up
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> is_producer_waiting;
+    std::atomic<bool> is_consumer_waiting;
+    std::mutex mutex_wait;
+    std::condition_variable cv_not_full;
+    std::condition_variable cv_not_empty;
+public:
+    SPSC_Queue(const size_t _capacity)
+    : length(_capacity+1), buf(_capacity+1),
+      wr_index(0), rd_index(0),
+      is_producer_waiting(false), is_consumer_waiting(false) {}
+    SPSC_Queue(SPSC_Queue&) = delete;
+    SPSC_Queue(SPSC_Queue&&) = delete;
+    SPSC_Queue& operator=(SPSC_Queue&) = delete;
+    SPSC_Queue& operator=(SPSC_Queue&&) = delete;
+
+    // Producer thread
+    bool TryPush(const T& x) {
+        if (!try_push(x)) {
+            return false;
+        }
+        wake(is_consumer_waiting, cv_not_empty);
+        return true;
+    }
+    void Push(const T& x) {
+        if (!try_push(x)) {
+            auto lock = std::unique_lock(mutex_wait);
+            is_producer_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_not_full.wait(lock, [this, &x]() { return try_push(x); });
+            is_producer_waiting.store(false, std::memory_order_relaxed);
+        }
+        wake(is_consumer_waiting, cv_not_empty);
+    }
+
+    // Consumer thread
+    bool TryPop(T& x) {
+        if (!try_pop(x)) {
+            return false;
+        }
+        wake(is_producer_waiting, cv_not_full);
+        return true;
+    }
+    T Pop() {
+        T x;
+        if (!try_pop(x)) {
+            auto lock = std::unique_lock(mutex_wait);
+            is_consumer_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_not_empty.wait(lock, [this, &x]() { return try_pop(x); });
+            is_consumer_waiting.store(false, std::memory_order_relaxed);
+        }
+        wake(is_producer_waiting, cv_not_full);
+        return x;
+    }
+
+    size_t Capacity() const { return length-1; }
+private:
+    bool try_push(const T& x) {
+        const size_t wr = wr_index.load(std::memory_order_relaxed);
+        const size_t wr_next = (wr+1) % length;
+        if (wr_next == rd_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+        buf[wr] = x;
+        wr_index.store(wr_next, std::memory_order_release);
+        return true;
+    }
+    bool try_pop(T& x) {
+        const size_t rd = rd_index.load(std::memory_order_relaxed);
+        if (rd == wr_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+        x = buf[rd];
+        rd_index.store((rd+1) % length, std::memory_order_release);
+        return true;
+    }
+    // The fence orders our index update before reading the other thread's waiting flag
+    // A waiting thread sets its flag with the same fence before checking the queue again
+    // So either it sees our update or we see its flag, and it can't sleep through the update
+    void wake(std::atomic<bool>& is_waiting, std::condition_variable& cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (is_waiting.load(std::memory_order_relaxed)) {
+            auto lock = std::scoped_lock(mutex_wait);
+            cv.notify_one();
+        }
+    }
+};
@@ -36,6 +36,8 @@ struct Renderer {
     struct AppRenderState {
         QAM_Synchroniser_Specification original_qam_sync_spec;
         int shared_block_size;
+        // the snapshot buffer can be swapped by the app so it is fetched again each frame
+        bool is_rendering_snapshot;
         QAM_Synchroniser_Buffer* render_buffer;
         ImPlotRange xrange_audio_buffer;
         ImPlotRange xrange_dsp_buffers;
@@ -52,6 +54,7 @@ struct Renderer {
             const double audio_block_size = (double)app.GetAudioFilter().GetOutputBufferSize();
             s.original_qam_sync_spec = app.qam_sync_spec;
             s.shared_block_size = shared_block_size;
+            s.is_rendering_snapshot = false;
             s.render_buffer = &(app.GetActiveBuffer());
             s.xrange_audio_buffer = {0, audio_block_size};
             s.xrange_dsp_buffers = {0, (double)shared_block_size};
@@ -169,8 +172,9 @@ int main(int argc, char** argv)
     const int audio_buffer_size = (int)Faudio;
     const int decoder_buffer_size = 1024;
 
+    auto rx_source = FileSampleSource(fp_in);
     auto app = App(
-        fp_in, demod_block_size, 
+        rx_source, demod_block_size, 
         decoder_buffer_size, ds_factor, us_factor, 
         audio_buffer_size, Faudio);
 
@@ -442,6 +446,7 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
     // swap between live and snapshot buffer
     auto* active_buffer = &(app.GetActiveBuffer());
     auto* snapshot_buffer = &(app.GetSnapshotBuffer());
+    state.render_buffer = state.is_rendering_snapshot ? snapshot_buffer : active_buffer;
 
     auto get_xscale = [&state](const int N) -> double {
         const double x = (double)state.shared_block_size / (double)N;
@@ -464,14 +469,15 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
     ImGui::End();
 
     if (ImGui::Begin("Controls")) {
-        const bool is_rendering_snapshot = (state.render_buffer == snapshot_buffer);
-        if (!is_rendering_snapshot) {
+        if (!state.is_rendering_snapshot) {
             if (ImGui::Button("Snapshot")) {
                 app.controls.snapshot = true;
+                state.is_rendering_snapshot = true;
                 state.render_buffer = snapshot_buffer;
             }
         } else {
             if (ImGui::Button("Resume")) {
+                state.is_rendering_snapshot = false;
                 state.render_buffer = active_buffer;
             }
         }
@@ -560,13 +566,24 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
 
     ImGui::Begin("Raw signals");
     if (ImPlot::BeginPlot("Raw Signal")) {
-        auto buf = state.render_buffer->x_in;
+        // raw IQ is offset binary so it is centered while plotting
+        struct RawPlot {
+            const uint8_t* data;
+            double xscale;
+        };
+        auto get_raw_point = [](int i, void* user_data) -> ImPlotPoint {
+            const auto* plot = reinterpret_cast<const RawPlot*>(user_data);
+            return ImPlotPoint((double)i * plot->xscale, (double)plot->data[2*i] - 128.0);
+        };
+        auto buf = state.render_buffer->x_raw;
         const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
+        auto* data = reinterpret_cast<const uint8_t*>(buf.data());
+        RawPlot plot_I { &data[0], get_xscale(N) };
+        RawPlot plot_Q { &data[1], get_xscale(N) };
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_input_buffer.Min, &state.yrange_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        ImPlot::PlotLineG("I", get_raw_point, &plot_I, N);
+        ImPlot::PlotLineG("Q", get_raw_point, &plot_Q, N);
         ImPlot::EndPlot();
     }
     if (ImPlot::BeginPlot("Downsampled signal")) {